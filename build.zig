@@ -66,6 +66,9 @@ pub fn build(b: *std.Build) void {
             "src/vrt/camera.cpp",
             "src/vrt/gaussians-from-file.cpp",
             "src/vrt/thread-pool.cpp",
+            "src/vrt/lod.cpp",
+            "src/vrt/bvh.cpp",
+            "src/vrt/grid.cpp",
         },
         .flags = &flags,
     });
@@ -1,6 +1,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <fmt/core.h>
+#include <optional>
 #include <thread>
 #include <vk-renderer/vk-renderer.h>
 #include <include/error_fmt.h>
@@ -41,6 +42,13 @@
     "\t--initial-rotation <rot>, -i <rot>:     Sets the initial rotation to <rot>.\n"\
     "\t--camaera-offset <offset>, -c <offset>: Set the position of the camera along the Z-Axis to <offset>.\n"\
     "\t--focal-length <focal-length>:          Set the focal length of the camera to <focal-length>.\n"\
+    "\t--packet-width <width>:                 Set the width of the pixel packets of mode 17, 18, 31 and 32 to <width> (4, 8 or 16).\n"\
+    "\t--tolerance <tolerance>:                Set the error tolerance per gaussian of the adaptive quadrature of mode 19 and 20.\n"\
+    "\t--quadrature <rule>:                    Set the quadrature rule of the radiance integral to <rule> (0 - riemann, 1 - gauss-hermite, 2 - symmetric).\n"\
+    "\t--accumulate:                           Average the frames of mode 21 and 22 while the camera and the gaussians do not change.\n"\
+    "\t--lod <size>:                           Render a level of detail cut whose gaussians project to at least <size> pixels. 0 disables it.\n"\
+    "\t--tile-budget <count>:                  Split the tiles of mode 33 until they hold at most <count> gaussians.\n"\
+    "\t--cutoff-error <lsb>:                   Let the culling and tiling neglect gaussians that change a pixel by less than <lsb> of 255.\n"\
     "\t--mode <mode>, -m <mode>:               Set the rendering mode to <mode>:\n"\
         "\t\t1 - sequential execution without tiling\n"\
         "\t\t2 - parallel transmittance calculation without tiling\n"\
@@ -49,7 +57,32 @@
         "\t\t5 - sequential execution with tiling\n"\
         "\t\t6 - parallel transmittance calculation with tiling\n"\
         "\t\t7 - parallel radiance calculation with tiling\n"\
-        "\t\t8 - parallel pixel calculation with tiling\n"
+        "\t\t8 - parallel pixel calculation with tiling\n"\
+        "\t\t9 - parallel pixel calculation with precomputed ray parameters without tiling\n"\
+        "\t\t10 - parallel pixel calculation with precomputed ray parameters with tiling\n"\
+        "\t\t11 - depth sorted transmittance calculation without tiling\n"\
+        "\t\t12 - depth sorted transmittance calculation with tiling\n"\
+        "\t\t13 - front to back parallel pixel calculation with early ray termination without tiling\n"\
+        "\t\t14 - front to back parallel pixel calculation with early ray termination with tiling\n"\
+        "\t\t15 - parallel pixel calculation with per packet culling of the gaussians without tiling\n"\
+        "\t\t16 - parallel pixel calculation with per packet culling of the gaussians with tiling\n"\
+        "\t\t17 - parallel pixel calculation with per packet cone culling of the gaussians without tiling\n"\
+        "\t\t18 - parallel pixel calculation with per packet cone culling of the gaussians with tiling\n"\
+        "\t\t19 - depth sorted transmittance calculation with adaptive quadrature without tiling\n"\
+        "\t\t20 - depth sorted transmittance calculation with adaptive quadrature with tiling\n"\
+        "\t\t21 - parallel pixel calculation with stochastic transmittance without tiling\n"\
+        "\t\t22 - parallel pixel calculation with stochastic transmittance with tiling\n"\
+        "\t\t23 - parallel pixel calculation of anisotropic gaussians without tiling\n"\
+        "\t\t24 - parallel pixel calculation of anisotropic gaussians with tiling\n"\
+        "\t\t25 - parallel pixel calculation with half precision error functions without tiling\n"\
+        "\t\t26 - parallel pixel calculation with half precision error functions with tiling\n"\
+        "\t\t27 - register blocked precomputed ray parameters without tiling\n"\
+        "\t\t28 - register blocked precomputed ray parameters with tiling\n"\
+        "\t\t29 - incremental ray parameters across the pixels of a tile without tiling\n"\
+        "\t\t30 - incremental ray parameters across the pixels of a tile with tiling\n"\
+        "\t\t31 - parallel pixel calculation with per packet bounding volume hierarchy traversal (always without tiling)\n"\
+        "\t\t32 - parallel pixel calculation with per packet uniform grid traversal (always without tiling)\n"\
+        "\t\t33 - parallel pixel calculation with adaptive quadtree tiling (always with tiling)\n"
 
 struct cmd_args_t
 {
@@ -66,6 +99,27 @@ struct cmd_args_t
     bool use_simd_transmittance = false;
     bool use_simd_l_hat = false;
     bool use_simd_pixels = true;
+    bool use_precomputed_rays = false;
+    bool use_sorted_transmittance = false;
+    bool use_early_termination = false;
+    bool use_culling = false;
+    bool use_cone_culling = false;
+    u64 packet_width = SIMD_FLOATS;
+    bool use_adaptive_quadrature = false;
+    f32 tolerance = vrt::adaptive_quadrature.tolerance;
+    i32 quadrature = 0;
+    bool use_stochastic_transmittance = false;
+    bool accumulate = false;
+    bool use_anisotropic = false;
+    bool use_fp16 = false;
+    bool use_blocking = false;
+    bool use_incremental = false;
+    bool use_bvh = false;
+    bool use_uniform_grid = false;
+    bool use_quadtree = false;
+    u64 tile_budget = 256;
+    f32 cutoff_error = .5f;
+    f32 lod_size = 0.f;
     f32 rot = 360.f;
     f32 inital_rot = 0.f;
     f32 camera_offset = -4.f;
@@ -87,6 +141,13 @@ struct cmd_args_t
             { "initial-rotation", required_argument, NULL, 'i'},
             { "camera-offset", required_argument, NULL, 'c' },
             { "focal-length", required_argument, NULL, 0xfe },
+            { "packet-width", required_argument, NULL, 0xfd },
+            { "tolerance", required_argument, NULL, 0xfc },
+            { "quadrature", required_argument, NULL, 0xfb },
+            { "accumulate", no_argument, NULL, 0xfa },
+            { "lod", required_argument, NULL, 0xf9 },
+            { "tile-budget", required_argument, NULL, 0xf8 },
+            { "cutoff-error", required_argument, NULL, 0xf7 },
             { "help", no_argument, NULL, 0xff }
         };
         i32 lidx;
@@ -147,11 +208,46 @@ struct cmd_args_t
                 case 0xfe:
                     this->focal_length = strtof(optarg, NULL);
                     break;
+                case 0xfd:
+                    this->packet_width = strtoul(optarg, NULL, 10);
+                    break;
+                case 0xfc:
+                    this->tolerance = strtof(optarg, NULL);
+                    break;
+                case 0xfb:
+                    this->quadrature = strtol(optarg, NULL, 10);
+                    break;
+                case 0xfa:
+                    this->accumulate = true;
+                    break;
+                case 0xf9:
+                    this->lod_size = strtof(optarg, NULL);
+                    break;
+                case 0xf8:
+                    this->tile_budget = strtoul(optarg, NULL, 10);
+                    break;
+                case 0xf7:
+                    this->cutoff_error = std::max(strtof(optarg, NULL), 1e-3f);
+                    break;
                 case 'm':
                     u64 mode = strtoul(optarg, NULL, 10);
                     this->use_tiling = false;
                     this->use_simd_transmittance = false;
                     this->use_simd_pixels = false;
+                    this->use_precomputed_rays = false;
+                    this->use_sorted_transmittance = false;
+                    this->use_early_termination = false;
+                    this->use_culling = false;
+                    this->use_cone_culling = false;
+                    this->use_adaptive_quadrature = false;
+                    this->use_stochastic_transmittance = false;
+                    this->use_anisotropic = false;
+                    this->use_fp16 = false;
+                    this->use_blocking = false;
+                    this->use_incremental = false;
+                    this->use_bvh = false;
+                    this->use_uniform_grid = false;
+                    this->use_quadtree = false;
                     switch (mode) {
                         case 5: // tiling sequential
                             this->use_tiling = true;
@@ -167,6 +263,86 @@ struct cmd_args_t
                         case 3: // no tiling pixels
                             this->use_simd_l_hat = true;
                             break;
+                        case 10: // tiling precomputed ray parameters
+                            this->use_tiling = true;
+                        case 9: // no tiling precomputed ray parameters
+                            this->use_simd_pixels = true;
+                            this->use_precomputed_rays = true;
+                            break;
+                        case 12: // tiling depth sorted transmittance
+                            this->use_tiling = true;
+                        case 11: // no tiling depth sorted transmittance
+                            this->use_sorted_transmittance = true;
+                            break;
+                        case 14: // tiling early ray termination
+                            this->use_tiling = true;
+                        case 13: // no tiling early ray termination
+                            this->use_simd_pixels = true;
+                            this->use_early_termination = true;
+                            break;
+                        case 16: // tiling culled gaussians
+                            this->use_tiling = true;
+                        case 15: // no tiling culled gaussians
+                            this->use_simd_pixels = true;
+                            this->use_culling = true;
+                            break;
+                        case 18: // tiling cone culled gaussians
+                            this->use_tiling = true;
+                        case 17: // no tiling cone culled gaussians
+                            this->use_simd_pixels = true;
+                            this->use_cone_culling = true;
+                            break;
+                        case 20: // tiling adaptive quadrature
+                            this->use_tiling = true;
+                        case 19: // no tiling adaptive quadrature
+                            this->use_adaptive_quadrature = true;
+                            break;
+                        case 22: // tiling stochastic transmittance
+                            this->use_tiling = true;
+                        case 21: // no tiling stochastic transmittance
+                            this->use_simd_pixels = true;
+                            this->use_stochastic_transmittance = true;
+                            break;
+                        case 24: // tiling anisotropic gaussians
+                            this->use_tiling = true;
+                        case 23: // no tiling anisotropic gaussians
+                            this->use_simd_pixels = true;
+                            this->use_anisotropic = true;
+                            break;
+                        case 26: // tiling half precision error functions
+                            this->use_tiling = true;
+                        case 25: // no tiling half precision error functions
+                            this->use_simd_pixels = true;
+                            this->use_fp16 = true;
+                            break;
+                        case 28: // tiling register blocked precomputed ray parameters
+                            this->use_tiling = true;
+                        case 27: // no tiling register blocked precomputed ray parameters
+                            this->use_simd_pixels = true;
+                            this->use_precomputed_rays = true;
+                            this->use_blocking = true;
+                            break;
+                        case 30: // tiling incremental ray parameters
+                            this->use_tiling = true;
+                        case 29: // no tiling incremental ray parameters
+                            this->use_simd_pixels = true;
+                            this->use_incremental = true;
+                            break;
+                        case 31: // bounding volume hierarchy, the hierarchy spans all gaussians so there is no tiling
+                            this->use_tiling = false;
+                            this->use_simd_pixels = true;
+                            this->use_bvh = true;
+                            break;
+                        case 32: // uniform grid, the grid spans all gaussians so there is no tiling
+                            this->use_tiling = false;
+                            this->use_simd_pixels = true;
+                            this->use_uniform_grid = true;
+                            break;
+                        case 33: // adaptive quadtree tiling, the tiles are split from the uniform ones so there is always tiling
+                            this->use_tiling = true;
+                            this->use_simd_pixels = true;
+                            this->use_quadtree = true;
+                            break;
                         default:
                         case 8:
                             this->use_tiling = true;
@@ -183,6 +359,18 @@ struct cmd_args_t
     }
 };
 
+/// Renders the image with cone culling per packet of `packet_width` x `SIMD_FLOATS / packet_width` pixels.
+template<typename Quadrature, vrt::cull_func_t Cull = vrt::cone_cull_gaussians, typename... Args>
+bool cone_culled_render_image(const u64 packet_width, Args&&... args)
+{
+    constexpr vrt::broadcast_radiance_func_t radiance = vrt::culled_broadcast_radiance<simd::exp, simd::erf, Cull, Quadrature>;
+    if constexpr (SIMD_FLOATS % 4 == 0)
+        if (packet_width == 4) return vrt::simd_render_image<simd::exp, simd::erf, Quadrature, radiance, 4>(std::forward<Args>(args)...);
+    if constexpr (SIMD_FLOATS % 8 == 0)
+        if (packet_width == 8) return vrt::simd_render_image<simd::exp, simd::erf, Quadrature, radiance, 8>(std::forward<Args>(args)...);
+    return vrt::simd_render_image<simd::exp, simd::erf, Quadrature, radiance, SIMD_FLOATS>(std::forward<Args>(args)...);
+}
+
 i32 main(i32 argc, char **argv)
 {
     cmd_args_t cmd(argc, argv);
@@ -205,14 +393,48 @@ i32 main(i32 argc, char **argv)
     }
 
 
+    vrt::set_cutoff_radii(_gaussians, cmd.cutoff_error / 255.f);
+    vrt::sample_culling.threshold = .5f / 255.f;
     std::vector<vrt::gaussian_t> staging_gaussians = _gaussians;
     vrt::gaussians_t gaussians{ .gaussians = _gaussians, .soa_gaussians = vrt::gaussian_vec_t::from_gaussians(_gaussians) };
     
     std::unique_ptr<renderer_t> renderer = (cmd.quiet) ? nullptr : std::make_unique<renderer_t>();
     f32 draw_time = 0.f, tiling_time = 0.f, total_time = 0.f;
+    f32 samples_per_pair = 0.f;
+    f32 skip_rate = 0.f;
     bool use_simd_transmittance = cmd.use_simd_transmittance;
     bool use_simd_l_hat = cmd.use_simd_l_hat;
     bool use_simd_pixels = cmd.use_simd_pixels;
+    bool use_precomputed_rays = cmd.use_precomputed_rays;
+    bool use_sorted_transmittance = cmd.use_sorted_transmittance;
+    bool use_early_termination = cmd.use_early_termination;
+    bool use_culling = cmd.use_culling;
+    bool use_cone_culling = cmd.use_cone_culling;
+    bool use_adaptive_quadrature = cmd.use_adaptive_quadrature;
+    vrt::adaptive_quadrature.tolerance = cmd.tolerance;
+    i32 quadrature = cmd.quadrature;
+    bool use_stochastic_transmittance = cmd.use_stochastic_transmittance;
+    bool accumulate = cmd.accumulate;
+    bool use_anisotropic = cmd.use_anisotropic;
+    bool use_fp16 = cmd.use_fp16;
+    bool use_blocking = cmd.use_blocking;
+    bool use_incremental = cmd.use_incremental;
+    bool use_bvh = cmd.use_bvh;
+    vrt::bvh_t bvh;
+    f32 bvh_lod_size = 0.f;
+    bool use_uniform_grid = cmd.use_uniform_grid;
+    vrt::grid_t uniform_grid;
+    f32 grid_lod_size = 0.f;
+    bool use_quadtree = cmd.use_quadtree;
+    i32 tile_budget = cmd.tile_budget;
+    f32 cutoff_error = cmd.cutoff_error;
+    const std::vector<vrt::gaussian_t> no_gaussians;
+    bool use_incremental_tiling = true;
+    vrt::incremental_tiler_t tiler;
+    f32 lod_size = cmd.lod_size;
+    vrt::lod_tree_t lod = vrt::lod_tree_t::build(staging_gaussians);
+    std::vector<vrt::gaussian_t> lod_gaussians;
+    vrt::temporal_accumulator_t accumulator;
     bool use_tiling = cmd.use_tiling;
 
     u64 width = cmd.w, height = cmd.h;
@@ -227,10 +449,17 @@ i32 main(i32 argc, char **argv)
         if (!renderer->init(width, height, "SIMD VRT")) return EXIT_FAILURE;
         renderer->custom_imgui = [&](){
             ImGui::Begin("Gaussians");
-            for (vrt::gaussian_t &g : staging_gaussians) g.imgui_controls();
+            /// NOTE: the radii follow the edits of the gaussians and the error, which rebuilds everything that uses them
+            for (vrt::gaussian_t &g : staging_gaussians)
+            {
+                g.imgui_controls();
+                g.radius = vrt::cutoff_radius(g, cutoff_error / 255.f);
+            }
             ImGui::End();
             ImGui::Begin("Debug");
             ImGui::Text("Tiling Time: %f ms", tiling_time);
+            ImGui::Checkbox("use incremental tiling", &use_incremental_tiling);
+            ImGui::Text("Updated Tiles: %lu%s", tiler.updated_tiles, tiler.rebuilt ? " (rebuilt)" : "");
             ImGui::Text("Draw Time: %f ms", draw_time);
             ImGui::Text("Frame Time: %f", current_frame);
             ImGui::Text("FPS: %f", 1000.f / current_frame);
@@ -238,6 +467,31 @@ i32 main(i32 argc, char **argv)
             ImGui::Checkbox("use parallel transmittance", &use_simd_transmittance);
             ImGui::Checkbox("use parallel radiance", &use_simd_l_hat);
             ImGui::Checkbox("use parallel pixels", &use_simd_pixels);
+            ImGui::Checkbox("use precomputed ray parameters", &use_precomputed_rays);
+            ImGui::Checkbox("use register blocking", &use_blocking);
+            ImGui::Checkbox("use incremental ray parameters", &use_incremental);
+            ImGui::Checkbox("use bounding volume hierarchy", &use_bvh);
+            ImGui::Checkbox("use uniform grid", &use_uniform_grid);
+            ImGui::Checkbox("use quadtree tiling", &use_quadtree);
+            ImGui::SliderInt("tile budget", &tile_budget, 1, 4096);
+            ImGui::SliderFloat("cutoff error (lsb)", &cutoff_error, 1e-3f, 8.f);
+            ImGui::Checkbox("use depth sorted transmittance", &use_sorted_transmittance);
+            ImGui::Checkbox("use early ray termination", &use_early_termination);
+            ImGui::Checkbox("use per packet culling", &use_culling);
+            ImGui::Checkbox("use per packet cone culling", &use_cone_culling);
+            ImGui::Checkbox("use adaptive quadrature", &use_adaptive_quadrature);
+            ImGui::SliderFloat("tolerance", &vrt::adaptive_quadrature.tolerance, 0.f, 1e-2f, "%.5f");
+            ImGui::Text("Samples per Gaussian: %f", samples_per_pair);
+            ImGui::Combo("quadrature", &quadrature, "riemann\0gauss-hermite\0symmetric\0");
+            ImGui::Checkbox("use stochastic transmittance", &use_stochastic_transmittance);
+            ImGui::SliderFloat("sample culling threshold", &vrt::sample_culling.threshold, 0.f, 4.f / 255.f, "%.5f");
+            ImGui::Text("Skipped Gaussians: %f", skip_rate);
+            ImGui::Checkbox("accumulate frames", &accumulate);
+            ImGui::Checkbox("use anisotropic gaussians", &use_anisotropic);
+            ImGui::Checkbox(vrt::has_fp16() ? "use half precision" : "use half precision (unsupported, f32 fallback)", &use_fp16);
+            ImGui::SliderFloat("lod size (px)", &lod_size, 0.f, 4.f);
+            ImGui::Text("Rendered Gaussians: %lu", gaussians.gaussians.size());
+            ImGui::Text("Accumulated Frames: %lu", accumulator.frames);
             ImGui::End();
         };
     }
@@ -254,47 +508,145 @@ i32 main(i32 argc, char **argv)
     angle -= cmd.inital_rot;
     cam.turn(angle, 0.f);
 
+    glm::vec3 last_position = cam.position;
+    std::vector<vrt::gaussian_t> last_gaussians = staging_gaussians;
     while (running)
     {
         frames++;
+        const bool gaussians_changed = memcmp(last_gaussians.data(), staging_gaussians.data(), sizeof(vrt::gaussian_t) * staging_gaussians.size());
+        /// the accumulated frames are only valid as long as nothing but the random numbers changes
+        if (!accumulate || !use_stochastic_transmittance || cam.position != last_position || gaussians_changed)
+            accumulator.reset();
+        last_position = cam.position;
+        last_gaussians = staging_gaussians;
+        vrt::stochastic_transmittance.frame = accumulator.frames;
         clock_gettime(CLOCK_MONOTONIC, &start);
-        gaussians.gaussians = staging_gaussians;
-        gaussians.soa_gaussians->load_gaussians(staging_gaussians);
-        vrt::tiles_t tiles = tile_gaussians(2.f/cmd.tiles, 2.f/cmd.tiles, staging_gaussians, cam.view_matrix);
+        if (gaussians_changed) lod = vrt::lod_tree_t::build(staging_gaussians);
+        if (lod_size > 0.f)
+        {
+            lod_gaussians = lod.cut(cam, lod_size);
+            vrt::set_cutoff_radii(lod_gaussians, cutoff_error / 255.f);
+        }
+        /// NOTE: a cut never holds more gaussians than the scene, so the SoA buffers do not need to grow
+        const std::vector<vrt::gaussian_t> &scene = (lod_size > 0.f) ? lod_gaussians : staging_gaussians;
+        gaussians.gaussians = scene;
+        gaussians.soa_gaussians->load_gaussians(scene);
+        /// NOTE: the hierarchy does not depend on the view, so it is only rebuilt if the gaussians or the cut change
+        if (!use_bvh) gaussians.bvh = nullptr;
+        else if (gaussians.bvh == nullptr || gaussians_changed || lod_size > 0.f || lod_size != bvh_lod_size)
+        {
+            bvh = vrt::bvh_t::build(scene, cmd.thread_count);
+            bvh_lod_size = lod_size;
+            gaussians.bvh = &bvh;
+        }
+        /// NOTE: the grid is built with two parallel passes over the gaussians, so it keeps up with edits every frame
+        if (!use_uniform_grid) gaussians.grid = nullptr;
+        else if (gaussians.grid == nullptr || gaussians_changed || lod_size > 0.f || lod_size != grid_lod_size)
+        {
+            uniform_grid = vrt::grid_t::build(scene, cmd.thread_count);
+            grid_lod_size = lod_size;
+            gaussians.grid = &uniform_grid;
+        }
+        /// NOTE: the quadtree is split from its own uniform tiles, so the uniform tiles stay empty while it is in use
+        const bool quadtree_tiling = use_tiling && use_quadtree;
+        /// NOTE: the tiler misses the changes of the frames it is not used in, so it starts over once it is used again
+        std::optional<vrt::tiles_t> fresh_tiles;
+        if (quadtree_tiling || !use_incremental_tiling)
+        {
+            fresh_tiles.emplace(tile_gaussians(2.f/cmd.tiles, 2.f/cmd.tiles, quadtree_tiling ? no_gaussians : scene, cam.view_matrix, cam.focal_length, cmd.thread_count));
+            tiler.tiles.reset();
+        }
+        const vrt::tiles_t &tiles = fresh_tiles ? *fresh_tiles
+            : tiler.update(2.f/cmd.tiles, 2.f/cmd.tiles, scene, cam.view_matrix, cam.focal_length, gaussians_changed || lod_size > 0.f, cmd.thread_count);
+        const vrt::quadtree_tiles_t quadtree_tiles = quadtree_tiling
+            ? vrt::quadtree_tile_gaussians(2.f/cmd.tiles, 2.f/cmd.tiles, width, height, scene, cam.view_matrix, cam.focal_length, std::max(tile_budget, 1), SIMD_FLOATS, cmd.thread_count)
+            : vrt::quadtree_tiles_t();
         clock_gettime(CLOCK_MONOTONIC, &end);
         tiling_time = simd::timeSpecDiffNsec(end, start)/1000000.f;
 
         clock_gettime(CLOCK_MONOTONIC, &start);
-        bool res = false;
-        if (use_tiling)
+        /// renders the image with the selected mode and quadrature rule, `args` are either the tiles and thread count or the gaussians
+        auto render = [&](auto quadrature, auto&&... args) -> bool
         {
-            if (use_simd_pixels) res = vrt::simd_render_image(width, height, image, cam, origin, tiles, running, cmd.thread_count);
-            else if (use_simd_l_hat)
+            using Q = decltype(quadrature);
+            if (use_adaptive_quadrature)
+                return vrt::render_image<Q, vrt::adaptive_radiance<simd::exp, simd::erf, expf, Q>>(width, height, image, cam, origin, args...);
+            else if (use_sorted_transmittance)
+                return vrt::render_image<Q, vrt::sorted_radiance<simd::exp, simd::erf, expf, Q>>(width, height, image, cam, origin, args...);
+            else if (use_simd_pixels && use_anisotropic)
             {
-                res = vrt::render_image<vrt::simd_radiance>(width, height, image, cam, origin, tiles, running, cmd.thread_count);
+                return vrt::simd_render_image<simd::exp, simd::erf, Q, vrt::anisotropic_broadcast_radiance<simd::exp, simd::erf, Q>>(
+                        width, height, image, cam, origin, args...);
             }
-            else if (use_simd_transmittance) res = vrt::render_image(width, height, image, cam, origin, tiles, running, cmd.thread_count); 
-            else
+            else if (use_simd_pixels && use_stochastic_transmittance)
             {
-                res = vrt::render_image<vrt::radiance<vrt::transmittance>>(width, height, image, cam, origin, tiles, running, cmd.thread_count);
+                return vrt::simd_render_image<simd::exp, simd::erf, Q, vrt::stochastic_broadcast_radiance<simd::exp, simd::erf, 32, Q>>(
+                        width, height, image, cam, origin, args...);
             }
-        }
-        else
-        {
-            if (use_simd_pixels) res = vrt::simd_render_image(width, height, image, cam, origin, gaussians, running);
-            else if (use_simd_l_hat)
+            else if (use_simd_pixels && use_fp16)
             {
-                res = vrt::render_image<vrt::simd_radiance>(width, height, image, cam, origin, gaussians, running);
+                return vrt::simd_render_image<simd::exp, simd::erf, Q, vrt::fp16_broadcast_radiance<simd::exp, simd::erf, Q>>(
+                        width, height, image, cam, origin, args...);
             }
-            else if (use_simd_transmittance) res = vrt::render_image(width, height, image, cam, origin, gaussians, running);
-            else
+            else if (use_simd_pixels && use_early_termination)
+            {
+                return vrt::simd_render_image<simd::exp, simd::erf, Q, vrt::front_to_back_broadcast_radiance<simd::exp, simd::erf, vrt::TERMINATION_EPSILON, Q>>(
+                        width, height, image, cam, origin, args...);
+            }
+            else if (use_simd_pixels && use_bvh)
+                return cone_culled_render_image<Q, vrt::bvh_cull_gaussians>(cmd.packet_width, width, height, image, cam, origin, args...);
+            else if (use_simd_pixels && use_uniform_grid)
+                return cone_culled_render_image<Q, vrt::grid_cull_gaussians>(cmd.packet_width, width, height, image, cam, origin, args...);
+            else if (use_simd_pixels && use_cone_culling)
+                return cone_culled_render_image<Q>(cmd.packet_width, width, height, image, cam, origin, args...);
+            else if (use_simd_pixels && use_culling)
+            {
+                return vrt::simd_render_image<simd::exp, simd::erf, Q, vrt::culled_broadcast_radiance<simd::exp, simd::erf, vrt::cull_gaussians, Q>>(
+                        width, height, image, cam, origin, args...);
+            }
+            else if (use_simd_pixels && use_incremental)
+                return vrt::incremental_render_image<simd::exp, simd::erf, Q>(width, height, image, cam, origin, args...);
+            else if (use_simd_pixels && use_precomputed_rays && use_blocking)
+                return vrt::blocked_render_image<simd::exp, simd::erf, Q>(width, height, image, cam, origin, args...);
+            else if (use_simd_pixels && use_precomputed_rays)
             {
-                res = vrt::render_image<vrt::radiance<vrt::transmittance>>(width, height, image, cam, origin, gaussians, running);
+                return vrt::simd_render_image<simd::exp, simd::erf, Q, vrt::precomputed_broadcast_radiance<simd::exp, simd::erf, Q>>(
+                        width, height, image, cam, origin, args...);
             }
+            else if (use_simd_pixels) return vrt::simd_render_image<simd::exp, simd::erf, Q>(width, height, image, cam, origin, args...);
+            else if (use_simd_l_hat)
+                return vrt::render_image<Q, vrt::simd_radiance<simd::exp, simd::erf, Q>>(width, height, image, cam, origin, args...);
+            else if (use_simd_transmittance) return vrt::render_image<Q>(width, height, image, cam, origin, args...);
+            return vrt::render_image<Q, vrt::radiance<vrt::transmittance, Q>>(width, height, image, cam, origin, args...);
+        };
+        auto render_with = [&](auto quadrature) -> bool
+        {
+            if (quadtree_tiling)
+            {
+                return vrt::simd_render_image<simd::exp, simd::erf, decltype(quadrature)>(
+                        width, height, image, cam, origin, quadtree_tiles, running, cmd.thread_count);
+            }
+            if (use_tiling) return render(quadrature, tiles, running, cmd.thread_count);
+            return render(quadrature, gaussians, running);
+        };
+        bool res = false;
+        switch (quadrature)
+        {
+            case 1: res = render_with(vrt::gauss_hermite_quadrature_t{}); break;
+            case 2: res = render_with(vrt::symmetric_quadrature_t{}); break;
+            default: res = render_with(vrt::riemann_quadrature_t{}); break;
         }
         clock_gettime(CLOCK_MONOTONIC, &end);
         draw_time = simd::timeSpecDiffNsec(end, start)/1000000.f;
         if (res) break;
+        if (accumulate && use_stochastic_transmittance) accumulator.accumulate(image, width * height);
+        if (use_adaptive_quadrature)
+        {
+            samples_per_pair = vrt::adaptive_quadrature.samples / std::max<f32>(vrt::adaptive_quadrature.pairs, 1.f);
+            vrt::adaptive_quadrature.reset();
+        }
+        skip_rate = vrt::sample_culling.skipped / std::max<f32>(vrt::sample_culling.pairs, 1.f);
+        vrt::sample_culling.reset();
 
         if (cmd.outfile != nullptr)
         {
@@ -308,6 +660,10 @@ i32 main(i32 argc, char **argv)
         if (cmd.quiet)
         {
             if (cmd.nr_frames == 1) fmt::print("TIME: {} ms\n", draw_time + tiling_time);
+            if (cmd.nr_frames == 1 && use_adaptive_quadrature)
+                fmt::print("SAMPLES PER GAUSSIAN: {} (of {})\n", samples_per_pair,
+                        quadrature == 1 ? vrt::gauss_hermite_quadrature_t::count : quadrature == 2 ? vrt::symmetric_quadrature_t::count : vrt::riemann_quadrature_t::count);
+            if (cmd.nr_frames == 1) fmt::print("SKIPPED GAUSSIANS: {}\n", skip_rate);
             total_time += draw_time + tiling_time;
             if (cmd.nr_frames == frames)
             {
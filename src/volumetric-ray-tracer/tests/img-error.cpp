@@ -1,5 +1,7 @@
 #include <vrt/vrt.h>
 #include "include/error_fmt.h"
+#include <set>
+#include <tuple>
 #define VCL_NAMESPACE vcl
 #include <include/vectorclass/vectormath_exp.h>
 
@@ -24,25 +26,36 @@ i32 main()
                     .sigma = 1.f/4.f,
                     .magnitude = 3.f
                     });
-    tiles_t tiles = tile_gaussians(1.f/8.f, 1.f/8.f, _gaussians, glm::mat4(1.f));
+    soa_padding.reset();
+    tiles_t tiles = tile_gaussians(1.f/8.f, 1.f/8.f, _gaussians, glm::mat4(1.f), 1.f);
+    fmt::print("[ {} ]\tPadding: {} of {} lanes ({} with a whole padding vector per tile)\n", INFO_FMT("INFO"),
+            soa_padding.padding.load(), soa_padding.lanes.load(), soa_padding.previous_padding.load());
 
     u32 *ref_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
     const camera_t cam(camera_create_info_t{});
 
     const vec4f_t origin{0.f, 0.f, 0.f};
     fmt::print("[ {} ]\tGenerating Reference Image\n", INFO_FMT("INFO"));
-    render_image<radiance<transmittance>>(256, 256, ref_image, cam, origin, tiles, true, 16);
+    render_image<riemann_quadrature_t, radiance<transmittance>>(256, 256, ref_image, cam, origin, tiles, true, 16);
 
     fmt::print("[ {} ]\tGenerating Test Images\n", INFO_FMT("INFO"));
     u32 *svml_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
     u32 *fog_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
     u32 *my_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
+    u32 *ftb_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
+    u32 *adaptive_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
+    u32 *fp16_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
 
     simd_render_image(256, 256, svml_image, cam, origin, tiles, true, 16);
     simd_render_image<approx::vcl_exp, approx::simd_abramowitz_stegun_erf>(256, 256, fog_image, cam, origin, tiles, true, 16);
     simd_render_image<approx::simd_fast_exp, approx::simd_abramowitz_stegun_erf>(256, 256, my_image, cam, origin, tiles, true, 16);
+    simd_render_image<simd::exp, simd::erf, riemann_quadrature_t, front_to_back_broadcast_radiance>(256, 256, ftb_image, cam, origin, tiles, true, 16);
+    adaptive_quadrature.reset();
+    render_image<riemann_quadrature_t, adaptive_radiance>(256, 256, adaptive_image, cam, origin, tiles, true, 16);
+    const f64 adaptive_samples = adaptive_quadrature.samples / (f64)adaptive_quadrature.pairs;
+    simd_render_image<simd::exp, simd::erf, riemann_quadrature_t, fp16_broadcast_radiance>(256, 256, fp16_image, cam, origin, tiles, true, 16);
 
-    double svml_err = 0.0, fog_err = 0.0, my_err = 0.0;
+    double svml_err = 0.0, fog_err = 0.0, my_err = 0.0, ftb_err = 0.0, adaptive_err = 0.0, fp16_err = 0.0;
     for (u64 i = 0; i < 256 * 256; ++i)
     {
         float R = (ref_image[i] & 0xFF)/255.f, G = ((ref_image[i] & 0xFF00) >> 8)/255.f, B = ((ref_image[i] & 0xFF0000) >> 16)/255.f;
@@ -51,13 +64,142 @@ i32 main()
         float my_R = (my_image[i] & 0xFF)/255.f, my_G = ((my_image[i] & 0xFF00) >> 8)/255.f, my_B = ((my_image[i] & 0xFF0000) >> 16)/255.f;
         svml_err += SQ((R - svml_R), (G - svml_G), (B - svml_B));
         fog_err += SQ((R - fog_R), (G - fog_G), (B - fog_B));
+        float ftb_R = (ftb_image[i] & 0xFF)/255.f, ftb_G = ((ftb_image[i] & 0xFF00) >> 8)/255.f, ftb_B = ((ftb_image[i] & 0xFF0000) >> 16)/255.f;
         my_err += SQ((R - my_R), (G - my_G), (B - my_B));
+        float adaptive_R = (adaptive_image[i] & 0xFF)/255.f, adaptive_G = ((adaptive_image[i] & 0xFF00) >> 8)/255.f, adaptive_B = ((adaptive_image[i] & 0xFF0000) >> 16)/255.f;
+        ftb_err += SQ((R - ftb_R), (G - ftb_G), (B - ftb_B));
+        adaptive_err += SQ((R - adaptive_R), (G - adaptive_G), (B - adaptive_B));
+        float fp16_R = (fp16_image[i] & 0xFF)/255.f, fp16_G = ((fp16_image[i] & 0xFF00) >> 8)/255.f, fp16_B = ((fp16_image[i] & 0xFF0000) >> 16)/255.f;
+        fp16_err += SQ((R - fp16_R), (G - fp16_G), (B - fp16_B));
     }
     svml_err /= 256*256;
     fog_err /= 256*256;
     my_err /= 256*256;
+    ftb_err /= 256*256;
+    adaptive_err /= 256*256;
+    fp16_err /= 256*256;
 
-    fmt::print("SVML: {}\nFOG:  {}\nMINE: {}\n", svml_err, fog_err, my_err);
+    fmt::print("SVML: {}\nFOG:  {}\nMINE: {}\nFTB:  {}\n", svml_err, fog_err, my_err, ftb_err);
+    fmt::print("ADAPTIVE: {} ({} of {} samples per gaussian, tolerance {})\n", adaptive_err, adaptive_samples, riemann_quadrature_t::count, adaptive_quadrature.tolerance);
+    fmt::print("FP16: {} ({})\n", fp16_err, has_fp16() ? "avx512fp16" : "f32 fallback");
+
+    /// tiles with the cutoff radii against all gaussians. Next to the grid, whose radii exceed `SUPPORT_RADIUS`, there are
+    /// faint gaussians with smaller radii and very faint ones with a radius of 0, which are dropped from all tiles.
+    std::vector<gaussian_t> cutoff_gaussians = _gaussians;
+    for (u8 i = 0; i < grid_dim; ++i)
+        for (u8 j = 0; j < grid_dim; ++j)
+            cutoff_gaussians.push_back(gaussian_t {
+                    .albedo{ .5f, 1.f, .5f, 1.f },
+                    .mu{ -1.f + 1.f/grid_dim + i * 1.f/(grid_dim/2.f) + 1.f/(2.f*grid_dim), -1.f + 1.f/grid_dim + j * 1.f/(grid_dim/2.f), .5f },
+                    .sigma = 1.f/16.f,
+                    .magnitude = ((i + j) % 3 == 0) ? .3f : ((i + j) % 3 == 1) ? .05f : .003f
+                    });
+    set_cutoff_radii(cutoff_gaussians);
+    u64 small_radii = 0, zero_radii = 0;
+    for (const gaussian_t &g : cutoff_gaussians)
+    {
+        small_radii += g.radius > 0.f && g.radius < SUPPORT_RADIUS;
+        zero_radii += g.radius == 0.f;
+    }
+    const tiles_t cutoff_tiles = tile_gaussians(1.f/8.f, 1.f/8.f, cutoff_gaussians, cam.view_matrix, cam.focal_length);
+    const gaussians_t all_gaussians{ .gaussians = cutoff_gaussians, .soa_gaussians = gaussian_vec_t::from_gaussians(cutoff_gaussians) };
+    u32 *untiled_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
+    u32 *cutoff_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
+    simd_render_image(256, 256, untiled_image, cam, origin, all_gaussians, true);
+    simd_render_image(256, 256, cutoff_image, cam, origin, cutoff_tiles, true, 16);
+
+    /// `CUTOFF_ERROR` bounds the error of every neglected gaussian on its own, see `cutoff_radius`. The bound of a
+    /// gaussian on a ray that passes it at r standard deviations is (albedo + 1) * tau(r), which may not exceed
+    /// `CUTOFF_ERROR` outside of the tiles of the gaussian. A pixel may differ by the sum of the bounds of all gaussians
+    /// that its tile neglects, plus one step of the truncation to 8 bits.
+    std::vector<std::set<std::tuple<f32, f32, f32>>> tile_members(cutoff_tiles.w * cutoff_tiles.h);
+    for (u64 tidx = 0; tidx < tile_members.size(); ++tidx)
+        for (const gaussian_t &g : cutoff_tiles.gaussians[tidx].gaussians) tile_members[tidx].insert({ g.mu.x, g.mu.y, g.mu.z });
+    const u64 cutoff_tile_width = 256 * cutoff_tiles.tw / 2.f, cutoff_tile_height = 256 * cutoff_tiles.th / 2.f;
+    f32 gaussian_err = 0.f;
+    i32 cutoff_err = 0, pixel_excess = 0;
+    for (u64 i = 0; i < 256 * 256; ++i)
+    {
+        const u64 tidx = (i / 256 / cutoff_tile_height) * cutoff_tiles.w + (i % 256) / cutoff_tile_width;
+        vec4f_t n{ cam.projection_plane.xs[i] - origin.x, cam.projection_plane.ys[i] - origin.y, cam.projection_plane.zs[i] - origin.z };
+        n.normalize();
+        f32 pixel_bound = 0.f;
+        for (const gaussian_t &g : cutoff_gaussians)
+        {
+            if (tile_members[tidx].contains({ g.mu.x, g.mu.y, g.mu.z })) continue;
+            const vec4f_t oc = g.mu - origin;
+            const f32 r2 = (oc.dot(oc) - oc.dot(n) * oc.dot(n)) / (g.max_sigma() * g.max_sigma());
+            const f32 bound = (max_albedo(g.albedo) + 1.f) * g.magnitude * g.max_sigma() * INV_SQRT_2_PI * 2.f * std::exp(-r2 / 2.f);
+            gaussian_err = std::max(gaussian_err, bound);
+            pixel_bound += bound;
+        }
+        i32 err = 0;
+        for (u64 c = 0; c < 24; c += 8)
+            err = std::max(err, std::abs((i32)((untiled_image[i] >> c) & 0xFF) - (i32)((cutoff_image[i] >> c) & 0xFF)));
+        cutoff_err = std::max(cutoff_err, err);
+        pixel_excess = std::max(pixel_excess, err - (i32)std::floor(pixel_bound * 255.f) - 1);
+    }
+    u64 cutoff_entries = 0;
+    for (const gaussians_t &g : cutoff_tiles.gaussians) cutoff_entries += g.gaussians.size();
+    fmt::print("CUTOFF: largest error of a neglected gaussian {} of at most {}, largest pixel error {} and {} over its bound "
+            "({} tile entries, {} radii below {}, {} of 0)\n", gaussian_err, CUTOFF_ERROR, cutoff_err, std::max(pixel_excess, 0),
+            cutoff_entries, small_radii, SUPPORT_RADIUS, zero_radii);
+    if (small_radii == 0 || zero_radii == 0)
+    {
+        fmt::print("[ {} ]\tThe cutoff scene does not produce radii below the support and radii of 0\n", ERROR_FMT("ERROR"));
+        return EXIT_FAILURE;
+    }
+    /// NOTE: the tiles test the ellipses of the gaussians in single precision, hence the slack
+    if (gaussian_err > CUTOFF_ERROR * 1.01f || pixel_excess > 0)
+    {
+        fmt::print("[ {} ]\tThe cutoff radii exceed their error bound\n", ERROR_FMT("ERROR"));
+        return EXIT_FAILURE;
+    }
+
+    /// isolated gaussians, some of them in pairs, so that the tiles are empty or hold one or two gaussians. Those tiles
+    /// take the background fill and `closed_form_broadcast_radiance`, which need to match `broadcast_radiance`.
+    std::vector<gaussian_t> sparse_gaussians;
+    for (u8 i = 0; i < 4; ++i)
+        for (u8 j = 0; j < 4; ++j)
+            for (u8 k = 0; k <= (i + j) % 2; ++k)
+                sparse_gaussians.push_back(gaussian_t{
+                        .albedo{ i / 3.f, .5f, j / 3.f, 1.f },
+                        .mu{ -.75f + i * .5f + k * .02f, -.75f + j * .5f, 1.f + k * .05f },
+                        .sigma = 1.f/32.f,
+                        .magnitude = 20.f
+                        });
+    set_cutoff_radii(sparse_gaussians);
+    const tiles_t sparse_tiles = tile_gaussians(1.f/8.f, 1.f/8.f, sparse_gaussians, cam.view_matrix, cam.focal_length);
+    const gaussians_t all_sparse_gaussians{ .gaussians = sparse_gaussians, .soa_gaussians = gaussian_vec_t::from_gaussians(sparse_gaussians) };
+    u32 *sparse_image = (u32*)simd::aligned_malloc(sizeof(u32) * 256 * 256);
+    std::fill(sparse_image, sparse_image + 256 * 256, 0xFFFFFFFF);
+    simd_render_image(256, 256, untiled_image, cam, origin, all_sparse_gaussians, true);
+    simd_render_image(256, 256, sparse_image, cam, origin, sparse_tiles, true, 16);
+    u64 sparse_counts[3] = { 0, 0, 0 };
+    for (const gaussians_t &g : sparse_tiles.gaussians)
+        ++sparse_counts[(g.gaussians.empty()) ? 0 : (g.gaussians.size() <= CLOSED_FORM_MAX_GAUSSIANS) ? 1 : 2];
+    i32 sparse_err = 0;
+    bool background = true;
+    const u64 tile_width = 256 * sparse_tiles.tw / 2.f, tile_height = 256 * sparse_tiles.th / 2.f;
+    for (u64 i = 0; i < 256 * 256; ++i)
+    {
+        for (u64 c = 0; c < 24; c += 8)
+            sparse_err = std::max(sparse_err, std::abs((i32)((untiled_image[i] >> c) & 0xFF) - (i32)((sparse_image[i] >> c) & 0xFF)));
+        const u64 tidx = (i / 256 / tile_height) * sparse_tiles.w + (i % 256) / tile_width;
+        if (sparse_tiles.gaussians[tidx].gaussians.empty() && sparse_image[i] != 0) background = false;
+    }
+    fmt::print("SPARSE: {} of at most 1 ({} empty tiles, {} with at most {} gaussians, {} with more)\n", sparse_err, sparse_counts[0],
+            sparse_counts[1], CLOSED_FORM_MAX_GAUSSIANS, sparse_counts[2]);
+    if (sparse_counts[0] == 0 || sparse_counts[1] == 0)
+    {
+        fmt::print("[ {} ]\tThe sparse scene does not produce empty and sparse tiles\n", ERROR_FMT("ERROR"));
+        return EXIT_FAILURE;
+    }
+    if (sparse_err > 1 || !background)
+    {
+        fmt::print("[ {} ]\tThe fast paths for empty and sparse tiles do not match the general path\n", ERROR_FMT("ERROR"));
+        return EXIT_FAILURE;
+    }
 
     return EXIT_SUCCESS;
 }
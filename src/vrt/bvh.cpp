@@ -0,0 +1,285 @@
+#include "bvh.h"
+#include "thread-pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace vrt
+{
+    /// Number of bins per axis of the surface area heuristic.
+    static constexpr u64 SAH_BINS = 16;
+    /// NOTE: the library is compiled with -ffast-math, so the empty bounds use the largest finite float instead of infinity
+    static constexpr f32 BVH_MAX = std::numeric_limits<f32>::max();
+
+    /// Bounding sphere of the gaussian `index`. The builder reorders the spheres themselves instead of indices to them,
+    /// which keeps the passes over the spheres sequential in memory.
+    struct bvh_sphere_t
+    {
+        f32 x, y, z, radius;
+        u32 index;
+    };
+
+    struct bvh_bounds_t
+    {
+        f32 lo[3] = { BVH_MAX, BVH_MAX, BVH_MAX };
+        f32 hi[3] = { -BVH_MAX, -BVH_MAX, -BVH_MAX };
+
+        void grow(const bvh_sphere_t &s)
+        {
+            const f32 c[3] = { s.x, s.y, s.z };
+            for (u64 a = 0; a < 3; ++a)
+            {
+                this->lo[a] = std::min(this->lo[a], c[a] - s.radius);
+                this->hi[a] = std::max(this->hi[a], c[a] + s.radius);
+            }
+        }
+
+        void grow(const bvh_bounds_t &other)
+        {
+            for (u64 a = 0; a < 3; ++a)
+            {
+                this->lo[a] = std::min(this->lo[a], other.lo[a]);
+                this->hi[a] = std::max(this->hi[a], other.hi[a]);
+            }
+        }
+
+        f32 area() const
+        {
+            if (this->lo[0] > this->hi[0]) return 0.f;
+            const f32 dx = this->hi[0] - this->lo[0], dy = this->hi[1] - this->lo[1], dz = this->hi[2] - this->lo[2];
+            return dx * dy + dy * dz + dz * dx;
+        }
+    };
+
+    static inline f32 sphere_center(const bvh_sphere_t &s, const u64 axis)
+    {
+        return axis == 0 ? s.x : axis == 1 ? s.y : s.z;
+    }
+
+    /// Returns the sphere around the center of the bounding box of `count` spheres that contains all of them.
+    static bvh_sphere_t bounding_sphere(const bvh_sphere_t *spheres, const u64 count)
+    {
+        bvh_bounds_t bounds;
+        for (u64 i = 0; i < count; ++i) bounds.grow(spheres[i]);
+        bvh_sphere_t sphere{
+            .x = (bounds.lo[0] + bounds.hi[0]) / 2.f,
+            .y = (bounds.lo[1] + bounds.hi[1]) / 2.f,
+            .z = (bounds.lo[2] + bounds.hi[2]) / 2.f,
+            .radius = 0.f,
+            .index = 0
+        };
+        for (u64 i = 0; i < count; ++i)
+        {
+            const bvh_sphere_t &s = spheres[i];
+            const f32 d = std::sqrt((s.x - sphere.x) * (s.x - sphere.x) + (s.y - sphere.y) * (s.y - sphere.y) + (s.z - sphere.z) * (s.z - sphere.z));
+            sphere.radius = std::max(sphere.radius, d + s.radius);
+        }
+        return sphere;
+    }
+
+    /// Reorders the `count` spheres into two groups with a binned surface area heuristic over the centers
+    /// and returns the size of the first group. Spheres with equal centers are split in half.
+    static u64 sah_split(bvh_sphere_t *spheres, const u64 count)
+    {
+        f32 lo[3] = { BVH_MAX, BVH_MAX, BVH_MAX }, hi[3] = { -BVH_MAX, -BVH_MAX, -BVH_MAX };
+        for (u64 i = 0; i < count; ++i)
+        {
+            for (u64 a = 0; a < 3; ++a)
+            {
+                lo[a] = std::min(lo[a], sphere_center(spheres[i], a));
+                hi[a] = std::max(hi[a], sphere_center(spheres[i], a));
+            }
+        }
+
+        bool found = false;
+        f32 best_cost = 0.f;
+        u64 best_axis = 0, best_bin = 0;
+        for (u64 a = 0; a < 3; ++a)
+        {
+            if (hi[a] <= lo[a]) continue;
+            const f32 scale = SAH_BINS / (hi[a] - lo[a]);
+            bvh_bounds_t bounds[SAH_BINS];
+            u64 counts[SAH_BINS] = {};
+            for (u64 i = 0; i < count; ++i)
+            {
+                const bvh_sphere_t &s = spheres[i];
+                const u64 b = std::min<u64>((sphere_center(s, a) - lo[a]) * scale, SAH_BINS - 1);
+                bounds[b].grow(s);
+                ++counts[b];
+            }
+            /// sweep from the right to get the cost of the right side of every split
+            f32 right_cost[SAH_BINS];
+            bvh_bounds_t right;
+            u64 right_count = 0;
+            for (u64 b = SAH_BINS - 1; b > 0; --b)
+            {
+                right.grow(bounds[b]);
+                right_count += counts[b];
+                right_cost[b] = right.area() * right_count;
+            }
+            bvh_bounds_t left;
+            u64 left_count = 0;
+            for (u64 b = 1; b < SAH_BINS; ++b)
+            {
+                left.grow(bounds[b - 1]);
+                left_count += counts[b - 1];
+                const f32 cost = left.area() * left_count + right_cost[b];
+                if (left_count > 0 && left_count < count && (!found || cost < best_cost))
+                {
+                    found = true;
+                    best_cost = cost;
+                    best_axis = a;
+                    best_bin = b;
+                }
+            }
+        }
+
+        if (!found) return count / 2;
+        const f32 scale = SAH_BINS / (hi[best_axis] - lo[best_axis]);
+        const bvh_sphere_t *mid = std::partition(spheres, spheres + count, [&](const bvh_sphere_t &s) {
+            return std::min<u64>((sphere_center(s, best_axis) - lo[best_axis]) * scale, SAH_BINS - 1) < best_bin;
+        });
+        return mid - spheres;
+    }
+
+    /// Splits the `count` spheres into up to `SIMD_FLOATS` contiguous ranges by repeatedly splitting the
+    /// largest range. Ranges that fit into a single node are not split any further, so the leaves stay full.
+    /// Returns the first index and size of every range.
+    static std::vector<std::pair<u64, u64>> split_children(bvh_sphere_t *spheres, const u64 count)
+    {
+        std::vector<std::pair<u64, u64>> ranges;
+        if (count <= SIMD_FLOATS)
+        {
+            for (u64 i = 0; i < count; ++i) ranges.push_back({ i, 1 });
+            return ranges;
+        }
+        ranges.push_back({ 0, count });
+        while (ranges.size() < SIMD_FLOATS)
+        {
+            auto largest = std::max_element(ranges.begin(), ranges.end(), [](const auto &a, const auto &b) { return a.second < b.second; });
+            const auto [first, size] = *largest;
+            if (size <= SIMD_FLOATS) break;
+            const u64 left = sah_split(spheres + first, size);
+            *largest = { first, left };
+            ranges.push_back({ first + left, size - left });
+        }
+        return ranges;
+    }
+
+    static void set_child(bvh_node_t &node, const u64 j, const bvh_sphere_t &sphere, const u32 child, const bool leaf)
+    {
+        node.x[j] = sphere.x;
+        node.y[j] = sphere.y;
+        node.z[j] = sphere.z;
+        node.radius[j] = sphere.radius;
+        node.child[j] = child;
+        if (leaf) node.leaves |= 1u << j;
+    }
+
+    /// Builds the subtree over the `count` spheres into `nodes` and returns the index of its root.
+    static u32 build_node(bvh_sphere_t *spheres, const u64 count, std::vector<bvh_node_t> &nodes)
+    {
+        const u32 index = nodes.size();
+        nodes.emplace_back();
+        const std::vector<std::pair<u64, u64>> ranges = split_children(spheres, count);
+        for (u64 j = 0; j < ranges.size(); ++j)
+        {
+            const auto [first, size] = ranges[j];
+            if (size == 1)
+            {
+                set_child(nodes[index], j, spheres[first], spheres[first].index, true);
+                continue;
+            }
+            const bvh_sphere_t sphere = bounding_sphere(spheres + first, size);
+            /// NOTE: building the child grows `nodes`, so the parent is only accessed through its index afterwards
+            const u32 child = build_node(spheres + first, size, nodes);
+            set_child(nodes[index], j, sphere, child, false);
+        }
+        nodes[index].count = ranges.size();
+        return index;
+    }
+
+    bvh_t bvh_t::build(const std::vector<gaussian_t> &gaussians, const u64 thread_count)
+    {
+        bvh_t bvh;
+        if (gaussians.empty()) return bvh;
+
+        std::vector<bvh_sphere_t> spheres(gaussians.size());
+        for (u64 i = 0; i < gaussians.size(); ++i)
+        {
+            const gaussian_t &g = gaussians[i];
+            spheres[i] = bvh_sphere_t{ .x = g.mu.x, .y = g.mu.y, .z = g.mu.z,
+                .radius = g.support(), .index = (u32)i };
+        }
+
+        /// the subtrees of the root are built into separate node buffers in parallel and appended to the root afterwards
+        const std::vector<std::pair<u64, u64>> ranges = split_children(spheres.data(), spheres.size());
+        std::vector<std::vector<bvh_node_t>> subtrees(ranges.size());
+        {
+            std::unique_ptr<thread_pool_t> tp = (thread_count <= 1) ? nullptr : std::make_unique<thread_pool_t>(thread_count);
+            for (u64 j = 0; j < ranges.size(); ++j)
+            {
+                if (ranges[j].second == 1) continue;
+                std::function<void()> task = [&spheres, &subtrees, range{ranges[j]}, j] () {
+                    build_node(spheres.data() + range.first, range.second, subtrees[j]);
+                };
+                if (tp) tp->enqueue(task);
+                else task();
+            }
+        } // NOTE: end of the scope implicitly joins threads through destructor
+
+        bvh.nodes.emplace_back();
+        for (u64 j = 0; j < ranges.size(); ++j)
+        {
+            const auto [first, size] = ranges[j];
+            if (size == 1)
+            {
+                set_child(bvh.nodes[0], j, spheres[first], spheres[first].index, true);
+                continue;
+            }
+            const u32 offset = bvh.nodes.size();
+            for (bvh_node_t node : subtrees[j])
+            {
+                for (u64 c = 0; c < node.count; ++c)
+                    if (!(node.leaves >> c & 1)) node.child[c] += offset;
+                bvh.nodes.push_back(node);
+            }
+            set_child(bvh.nodes[0], j, bounding_sphere(spheres.data() + first, size), offset, false);
+        }
+        bvh.nodes[0].count = ranges.size();
+        return bvh;
+    }
+
+    u64 bvh_t::traverse(const simd_vec4f_t &o, const simd_vec4f_t &n, u32 *indices) const
+    {
+        if (this->nodes.empty()) return 0;
+        /// NOTE: one stack per thread since the tiles are rendered in parallel
+        static thread_local std::vector<u32> stack;
+        const packet_cone_t cone = packet_cone_t::from_rays(o, n);
+
+        u64 count = 0;
+        stack.clear();
+        stack.push_back(0);
+        while (!stack.empty())
+        {
+            const bvh_node_t &node = this->nodes[stack.back()];
+            stack.pop_back();
+            const simd::Vec<simd::Float> hit = simd::bit_and(tail_mask(node.count),
+                    cone.intersects(simd::load(node.x), simd::load(node.y), simd::load(node.z), simd::load(node.radius)));
+            for (u64 bits = simd::msb2int(hit); bits; bits &= bits - 1)
+            {
+                const u64 j = __builtin_ctzll(bits);
+                if (node.leaves >> j & 1) indices[count++] = node.child[j];
+                else stack.push_back(node.child[j]);
+            }
+        }
+        return count;
+    }
+
+    u64 bvh_cull_gaussians(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, u32 *indices)
+    {
+        if (gaussians.bvh == nullptr) return cone_cull_gaussians(o, n, gaussians, indices);
+        return gaussians.bvh->traverse(o, n, indices);
+    }
+};
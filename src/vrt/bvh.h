@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+#include "rt.h"
+
+namespace vrt
+{
+    /// Node of a `bvh_t` with up to `SIMD_FLOATS` children. The bounding spheres of the children are stored as SoA so
+    /// that a packet of rays is tested against all children of a node at once.
+    struct bvh_node_t
+    {
+        alignas(NATIVE_SIMD_WIDTH) f32 x[SIMD_FLOATS];
+        alignas(NATIVE_SIMD_WIDTH) f32 y[SIMD_FLOATS];
+        alignas(NATIVE_SIMD_WIDTH) f32 z[SIMD_FLOATS];
+        alignas(NATIVE_SIMD_WIDTH) f32 radius[SIMD_FLOATS];
+        /// Index of the child node or, if the bit of the child in `leaves` is set, of the gaussian.
+        u32 child[SIMD_FLOATS];
+        u32 leaves = 0;
+        u32 count = 0;
+    };
+
+    /// Bounding volume hierarchy over the spheres of radius `gaussian_t::support` around the gaussians,
+    /// the same support that `cull_gaussians` uses. Every node splits its gaussians with a binned surface area heuristic
+    /// into up to `SIMD_FLOATS` children. Children with a single gaussian are stored directly in their parent. The root
+    /// is the first node.
+    struct bvh_t
+    {
+        std::vector<bvh_node_t> nodes;
+
+        /// Builds the hierarchy of `gaussians`. The subtrees below the root are built in parallel with `thread_count`
+        /// threads.
+        static bvh_t build(const std::vector<gaussian_t> &gaussians, const u64 thread_count = 1);
+
+        /// Collects the gaussians whose bounding spheres intersect the cone around the given rays, see `packet_cone_t`.
+        /// The rays need to share their origin.
+        /// \param o the origins of the rays.
+        /// \param n the directions of the rays. These should be unit vectors.
+        /// \param indices output buffer for the indices of the intersecting gaussians. It needs to hold an element per
+        /// gaussian of the hierarchy.
+        /// \return the number of intersecting gaussians.
+        u64 traverse(const simd_vec4f_t &o, const simd_vec4f_t &n, u32 *indices) const;
+    };
+
+    /// Version of `cone_cull_gaussians` that traverses `gaussians.bvh` instead of testing every gaussian. The cost only
+    /// grows with the number of intersecting gaussians and the depth of the hierarchy. Falls back to
+    /// `cone_cull_gaussians` if the gaussians have no hierarchy.
+    u64 bvh_cull_gaussians(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, u32 *indices);
+};
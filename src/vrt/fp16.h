@@ -0,0 +1,179 @@
+#pragma once
+
+#include "rt.h"
+#include <immintrin.h>
+
+/// Half precision versions of the broadcast kernels. The error functions of the samples are evaluated for two gaussians at
+/// once in the 32 half precision lanes of an AVX-512 FP16 vector while the geometry, the weights and the sums stay in
+/// single precision. The kernels are compiled for AVX-512 FP16 through a target attribute and only called if the CPU
+/// supports it, every other CPU falls back to the single precision kernels at runtime. The kernels convert whole vectors
+/// of 16 floats, so they also fall back if `MAX_SIMD_WIDTH` limits the vectors to fewer lanes.
+#if NATIVE_SIMD_WIDTH == 64 && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VRT_FP16_KERNELS
+#define VRT_FP16_TARGET __attribute__((target("avx512fp16,avx512vl,avx512bw,avx512dq,avx512f")))
+#endif
+
+namespace vrt
+{
+    /// Returns whether the CPU running the program supports AVX-512 FP16.
+    inline bool has_fp16()
+    {
+#ifdef VRT_FP16_KERNELS
+        static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx512fp16"));
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+#ifdef VRT_FP16_KERNELS
+    namespace fp16
+    {
+        /// Converts two vectors of `SIMD_FLOATS` floats to the lower and upper half of a half precision vector.
+        VRT_FP16_TARGET inline __m512h pack(const simd::Vec<simd::Float> &lo, const simd::Vec<simd::Float> &hi)
+        {
+            const __m256h l = _mm512_cvtxps_ph(static_cast<__m512>(lo));
+            const __m256h h = _mm512_cvtxps_ph(static_cast<__m512>(hi));
+            return _mm512_castpd_ph(_mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castph_pd(l)), _mm256_castph_pd(h), 1));
+        }
+
+        /// Converts the lower and upper half of a half precision vector to floats and returns their sum.
+        VRT_FP16_TARGET inline simd::Vec<simd::Float> unpack_sum(const __m512h x)
+        {
+            const __m512 lo = _mm512_cvtxph_ps(_mm512_castph512_ph256(x));
+            const __m512 hi = _mm512_cvtxph_ps(_mm256_castpd_ph(_mm512_extractf64x4_pd(_mm512_castph_pd(x), 1)));
+            return simd::Vec<simd::Float>(_mm512_add_ps(lo, hi));
+        }
+
+        /// Half precision version of `approx::simd_abramowitz_stegun_erf`. The fourth power of the denominator overflows
+        /// for |x| > 3.7 which saturates the result to +-1 as the reciprocal of infinity is zero.
+        VRT_FP16_TARGET inline __m512h erf(const __m512h x)
+        {
+            const __m512i sign_bit = _mm512_set1_epi16((i16)0x8000);
+            const __m512h a = _mm512_abs_ph(x);
+            __m512h denom = _mm512_fmadd_ph(_mm512_set1_ph((_Float16)0.078108f), a, _mm512_set1_ph((_Float16)0.000972f));
+            denom = _mm512_fmadd_ph(denom, a, _mm512_set1_ph((_Float16)0.230389f));
+            denom = _mm512_fmadd_ph(denom, a, _mm512_set1_ph((_Float16)0.278393f));
+            denom = _mm512_fmadd_ph(denom, a, _mm512_set1_ph((_Float16)1.f));
+            const __m512h denom2 = _mm512_mul_ph(denom, denom);
+            const __m512h val = _mm512_sub_ph(_mm512_set1_ph((_Float16)1.f), _mm512_rcp_ph(_mm512_mul_ph(denom2, denom2)));
+            return _mm512_castsi512_ph(_mm512_or_si512(_mm512_castph_si512(val),
+                        _mm512_and_si512(_mm512_castph_si512(x), sign_bit)));
+        }
+
+        /// Quantities of a single gaussian along `SIMD_FLOATS` rays, see `fused_broadcast_transmittance`.
+        struct ray_gaussian_t
+        {
+            simd::Vec<simd::Float> weight;
+            /// (s[0] - mu_bar) / (sqrt(2) sigma), the argument of the second error function at the first sample.
+            simd::Vec<simd::Float> offset;
+            simd::Vec<simd::Float> inv_sqrt_2_sigma;
+        };
+
+        template<simd_f32_func_t Exp, simd_f32_func_t Erf>
+        VRT_FP16_TARGET inline ray_gaussian_t intersect(const simd_vec4f_t &o, const simd_vec4f_t &n, const simd::Vec<simd::Float> &s0,
+                const gaussian_vec_t &g, const u64 i, simd::Vec<simd::Float> &erf1_sum)
+        {
+            const simd_vec4f_t mu{ .x = simd::set1<simd::Float>(g.mu.x[i]), .y = simd::set1<simd::Float>(g.mu.y[i]), .z = simd::set1<simd::Float>(g.mu.z[i]) };
+            const simd_vec4f_t origin_to_center = mu - o;
+            const simd::Vec<simd::Float> mu_bar = origin_to_center.dot(n);
+            const simd::Vec<simd::Float> weight = simd::set1<simd::Float>(g.weight_scale[i])
+                * Exp(-((origin_to_center.sqnorm() - mu_bar * mu_bar) * simd::set1<simd::Float>(g.inv_2_sigma2[i])));
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::set1<simd::Float>(g.inv_sqrt_2_sigma[i]);
+            erf1_sum += weight * Erf(-(mu_bar * inv_sqrt_2_sig));
+            return { .weight = weight, .offset = (s0 - mu_bar) * inv_sqrt_2_sig, .inv_sqrt_2_sigma = inv_sqrt_2_sig };
+        }
+    };
+
+    /// Version of `fused_broadcast_transmittance` that evaluates the second error functions in half precision. The samples
+    /// are taken relative to the first one, so the arguments stay small wherever the error functions are not saturated,
+    /// and the exponents are accumulated in single precision.
+    /// \param o origins of the rays.
+    /// \param n directions of the rays. These should be unit vectors.
+    /// \param s points along the rays to sample.
+    /// \param gaussians the set of gaussians to compute the transmittance for.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, u64 K>
+    VRT_FP16_TARGET std::array<simd::Vec<simd::Float>, K> fp16_broadcast_transmittance(const simd_vec4f_t &o, const simd_vec4f_t &n,
+            const std::array<simd::Vec<simd::Float>, K> &s, const gaussians_t &gaussians)
+    {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        const u64 size = gaussians.gaussians.size();
+        __m512h ds[K];
+        for (u64 k = 0; k < K; ++k) ds[k] = fp16::pack(s[k] - s[0], s[k] - s[0]);
+
+        simd::Vec<simd::Float> erf1_sum = simd::set1<simd::Float>(0.f);
+        std::array<simd::Vec<simd::Float>, K> erf2_sum;
+        erf2_sum.fill(simd::set1<simd::Float>(0.f));
+        for (u64 i = 0; i < size; i += 2)
+        {
+            const fp16::ray_gaussian_t a = fp16::intersect<Exp, Erf>(o, n, s[0], g, i, erf1_sum);
+            /// NOTE: an odd number of gaussians pairs the last one with a copy of itself whose weight is zero
+            fp16::ray_gaussian_t b = a;
+            if (i + 1 < size) b = fp16::intersect<Exp, Erf>(o, n, s[0], g, i + 1, erf1_sum);
+            else b.weight = simd::set1<simd::Float>(0.f);
+
+            const __m512h weight = fp16::pack(a.weight, b.weight);
+            const __m512h offset = fp16::pack(a.offset, b.offset);
+            const __m512h inv_sqrt_2_sig = fp16::pack(a.inv_sqrt_2_sigma, b.inv_sqrt_2_sigma);
+            for (u64 k = 0; k < K; ++k)
+            {
+                const __m512h erf2 = fp16::erf(_mm512_fmadd_ph(ds[k], inv_sqrt_2_sig, offset));
+                erf2_sum[k] += fp16::unpack_sum(_mm512_mul_ph(weight, erf2));
+            }
+        }
+        std::array<simd::Vec<simd::Float>, K> T;
+        for (u64 k = 0; k < K; ++k) T[k] = Exp(erf1_sum - erf2_sum[k]);
+        return T;
+    }
+
+    /// Version of `broadcast_radiance` built on `fp16_broadcast_transmittance`. Requires AVX-512 FP16, see
+    /// `fp16_broadcast_radiance`.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t>
+    VRT_FP16_TARGET simd_vec4f_t fp16_broadcast_radiance_kernel(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        simd_vec4f_t L_hat{ .x = simd::set1<simd::Float>(0.f), .y = simd::set1<simd::Float>(0.f), .z = simd::set1<simd::Float>(0.f), .w = simd::set1<simd::Float>(0.f) };
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(gaussians.gaussians.size());
+        u64 skipped = 0;
+        for (u64 q = 0; q < gaussians.gaussians.size(); ++q)
+        {
+            const simd_gaussian_t G_q = simd_gaussian_t::from_gaussian_t(gaussians.gaussians[q]);
+            const simd::Vec<simd::Float> lambda_q = G_q.sigma;
+            const simd_vec4f_t origin_to_center = G_q.mu - o;
+            const simd::Vec<simd::Float> mu_bar = origin_to_center.dot(n);
+            const simd::Vec<simd::Float> c_bar = G_q.magnitude
+                * Exp(-((origin_to_center.sqnorm() - mu_bar * mu_bar) * simd::set1<simd::Float>(gaussians.soa_gaussians->inv_2_sigma2[q])));
+            if (simd::hmax(c_bar * lambda_q) * max_albedo(gaussians.gaussians[q].albedo) < cutoff)
+            {
+                ++skipped;
+                continue;
+            }
+            std::array<simd::Vec<simd::Float>, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda_q;
+            const std::array<simd::Vec<simd::Float>, Quadrature::count> T = fp16_broadcast_transmittance<Exp, Erf>(o, n, s, gaussians);
+            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * T[k];
+            L_hat = L_hat + (G_q.albedo * (c_bar * lambda_q * inner));
+        }
+        sample_culling.count(gaussians.gaussians.size(), skipped);
+        return L_hat;
+    }
+#endif
+
+    /// Version of `broadcast_radiance` that evaluates the error functions in half precision on CPUs with AVX-512 FP16 and
+    /// falls back to `broadcast_radiance` everywhere else.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t>
+    simd_vec4f_t fp16_broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+#ifdef VRT_FP16_KERNELS
+        if (has_fp16()) return fp16_broadcast_radiance_kernel<Exp, Erf, Quadrature>(o, n, gaussians);
+#endif
+        return broadcast_radiance<Exp, Erf, Quadrature>(o, n, gaussians);
+    }
+};
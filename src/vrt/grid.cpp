@@ -0,0 +1,213 @@
+#include "grid.h"
+#include "thread-pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace vrt
+{
+    /// NOTE: the library is compiled with -ffast-math, so the largest finite float stands in for infinity
+    static constexpr f32 GRID_MAX = std::numeric_limits<f32>::max();
+    /// Number of gaussians per task of the parallel build.
+    static constexpr u64 GRID_CHUNK = 16384;
+
+    grid_t grid_t::build(const std::vector<gaussian_t> &gaussians, const u64 thread_count, const f32 cells_per_gaussian)
+    {
+        grid_t grid;
+        grid.gaussian_count = gaussians.size();
+        if (gaussians.empty())
+        {
+            grid.cell_start.assign(1, 0);
+            return grid;
+        }
+
+        std::vector<f32> radius(gaussians.size());
+        f32 mean_radius = 0.f;
+        f32 hi[3] = { -GRID_MAX, -GRID_MAX, -GRID_MAX };
+        for (u64 a = 0; a < 3; ++a) grid.lo[a] = GRID_MAX;
+        for (u64 i = 0; i < gaussians.size(); ++i)
+        {
+            const gaussian_t &g = gaussians[i];
+            radius[i] = g.support();
+            mean_radius += radius[i] / gaussians.size();
+            const f32 mu[3] = { g.mu.x, g.mu.y, g.mu.z };
+            for (u64 a = 0; a < 3; ++a)
+            {
+                grid.lo[a] = std::min(grid.lo[a], mu[a] - radius[i]);
+                hi[a] = std::max(hi[a], mu[a] + radius[i]);
+            }
+        }
+
+        /// cubic cells whose number is proportional to the number of gaussians, but that are at least as large as the
+        /// average support so that a gaussian is listed in only a few cells
+        const f32 extent[3] = { std::max(hi[0] - grid.lo[0], 1e-6f), std::max(hi[1] - grid.lo[1], 1e-6f), std::max(hi[2] - grid.lo[2], 1e-6f) };
+        const f32 side = std::max(std::cbrt(extent[0] * extent[1] * extent[2] / std::max(cells_per_gaussian * gaussians.size(), 1.f)), 2.f * mean_radius);
+        u64 cell_count = 1;
+        for (u64 a = 0; a < 3; ++a)
+        {
+            grid.dims[a] = std::clamp<u32>(std::ceil(extent[a] / side), 1, 1024);
+            grid.cell_size[a] = extent[a] / grid.dims[a];
+            cell_count *= grid.dims[a];
+        }
+
+        auto cell_range = [&grid, &gaussians, &radius](const u64 i, u32 first[3], u32 last[3]) {
+            const f32 mu[3] = { gaussians[i].mu.x, gaussians[i].mu.y, gaussians[i].mu.z };
+            for (u64 a = 0; a < 3; ++a)
+            {
+                first[a] = std::clamp<i64>((mu[a] - radius[i] - grid.lo[a]) / grid.cell_size[a], 0, grid.dims[a] - 1);
+                last[a] = std::clamp<i64>((mu[a] + radius[i] - grid.lo[a]) / grid.cell_size[a], 0, grid.dims[a] - 1);
+            }
+        };
+
+        auto cell_index = [&grid](const u32 x, const u32 y, const u32 z) -> u64 {
+            return ((u64)z * grid.dims[1] + y) * grid.dims[0] + x;
+        };
+
+        /// sorts the gaussians by the cells of their centers first, so that the scatter below writes to the lists of
+        /// neighbouring cells one after another instead of jumping through the whole index buffer
+        std::vector<u32> counts(cell_count + 1, 0);
+        std::vector<u32> center(gaussians.size());
+        for (u64 i = 0; i < gaussians.size(); ++i)
+        {
+            const f32 mu[3] = { gaussians[i].mu.x, gaussians[i].mu.y, gaussians[i].mu.z };
+            u32 c[3];
+            for (u64 a = 0; a < 3; ++a) c[a] = std::clamp<i64>((mu[a] - grid.lo[a]) / grid.cell_size[a], 0, grid.dims[a] - 1);
+            center[i] = cell_index(c[0], c[1], c[2]);
+            ++counts[center[i] + 1];
+        }
+        for (u64 c = 0; c < cell_count; ++c) counts[c + 1] += counts[c];
+        std::vector<u32> order(gaussians.size());
+        for (u64 i = 0; i < gaussians.size(); ++i) order[counts[center[i]]++] = i;
+
+        /// counts the gaussians per cell, turns the counts into the starts of the lists and scatters the gaussians
+        std::fill(counts.begin(), counts.end(), 0);
+        parallel_chunks(gaussians.size(), GRID_CHUNK, thread_count, [&](const u64 begin, const u64 end) {
+            for (u64 j = begin; j < end; ++j)
+            {
+                const u32 i = order[j];
+                u32 first[3], last[3];
+                cell_range(i, first, last);
+                for (u32 z = first[2]; z <= last[2]; ++z)
+                    for (u32 y = first[1]; y <= last[1]; ++y)
+                        for (u32 x = first[0]; x <= last[0]; ++x)
+                            std::atomic_ref<u32>(counts[cell_index(x, y, z)]).fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        grid.cell_start.resize(cell_count + 1);
+        grid.cell_start[0] = 0;
+        for (u64 c = 0; c < cell_count; ++c) grid.cell_start[c + 1] = grid.cell_start[c] + counts[c];
+        grid.indices.resize(grid.cell_start[cell_count]);
+        std::copy(grid.cell_start.begin(), grid.cell_start.end(), counts.begin());
+        parallel_chunks(gaussians.size(), GRID_CHUNK, thread_count, [&](const u64 begin, const u64 end) {
+            for (u64 j = begin; j < end; ++j)
+            {
+                const u32 i = order[j];
+                u32 first[3], last[3];
+                cell_range(i, first, last);
+                for (u32 z = first[2]; z <= last[2]; ++z)
+                    for (u32 y = first[1]; y <= last[1]; ++y)
+                        for (u32 x = first[0]; x <= last[0]; ++x)
+                            grid.indices[std::atomic_ref<u32>(counts[cell_index(x, y, z)]).fetch_add(1, std::memory_order_relaxed)] = i;
+            }
+        });
+        return grid;
+    }
+
+    /// Appends the cells that the line o + t * n passes through to `cells` together with the parameter `t` at which it
+    /// enters them.
+    static void walk_cells(const grid_t &grid, const f32 o[3], const f32 n[3], std::vector<std::pair<f32, u32>> &cells)
+    {
+        /// clips the line to the bounds of the grid
+        f32 t_min = -GRID_MAX, t_max = GRID_MAX;
+        for (u64 a = 0; a < 3; ++a)
+        {
+            const f32 hi = grid.lo[a] + grid.dims[a] * grid.cell_size[a];
+            if (std::abs(n[a]) < 1e-12f)
+            {
+                if (o[a] < grid.lo[a] || o[a] > hi) return;
+                continue;
+            }
+            const f32 t0 = (grid.lo[a] - o[a]) / n[a], t1 = (hi - o[a]) / n[a];
+            t_min = std::max(t_min, std::min(t0, t1));
+            t_max = std::min(t_max, std::max(t0, t1));
+        }
+        if (t_min > t_max) return;
+
+        i64 cell[3], step[3];
+        f32 t_next[3], t_delta[3];
+        for (u64 a = 0; a < 3; ++a)
+        {
+            const f32 p = o[a] + n[a] * t_min;
+            cell[a] = std::clamp<i64>((p - grid.lo[a]) / grid.cell_size[a], 0, grid.dims[a] - 1);
+            if (std::abs(n[a]) < 1e-12f)
+            {
+                step[a] = 0;
+                t_next[a] = GRID_MAX;
+                t_delta[a] = GRID_MAX;
+                continue;
+            }
+            step[a] = n[a] > 0.f ? 1 : -1;
+            t_delta[a] = grid.cell_size[a] / std::abs(n[a]);
+            t_next[a] = (grid.lo[a] + (cell[a] + (step[a] > 0)) * grid.cell_size[a] - o[a]) / n[a];
+        }
+
+        f32 t = t_min;
+        while (true)
+        {
+            cells.push_back({ t, (u32)((cell[2] * grid.dims[1] + cell[1]) * grid.dims[0] + cell[0]) });
+            const u64 a = (t_next[0] < t_next[1]) ? (t_next[0] < t_next[2] ? 0 : 2) : (t_next[1] < t_next[2] ? 1 : 2);
+            t = t_next[a];
+            if (t > t_max) return;
+            cell[a] += step[a];
+            if (cell[a] < 0 || cell[a] >= grid.dims[a]) return;
+            t_next[a] += t_delta[a];
+        }
+    }
+
+    u64 grid_t::traverse(const simd_vec4f_t &o, const simd_vec4f_t &n, u32 *indices) const
+    {
+        if (this->indices.empty()) return 0;
+        /// NOTE: one set of scratch buffers per thread since the tiles are rendered in parallel. The stamps mark the
+        /// gaussians that were already collected for the current packet, which avoids clearing them per packet.
+        static thread_local std::vector<std::pair<f32, u32>> cells;
+        static thread_local std::vector<u32> stamps;
+        static thread_local u32 stamp = 0;
+        if (stamps.size() < this->gaussian_count) stamps.resize(this->gaussian_count, 0);
+        if (++stamp == 0)
+        {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+
+        alignas(NATIVE_SIMD_WIDTH) f32 ox[SIMD_FLOATS], oy[SIMD_FLOATS], oz[SIMD_FLOATS], nx[SIMD_FLOATS], ny[SIMD_FLOATS], nz[SIMD_FLOATS];
+        simd::store(ox, o.x); simd::store(oy, o.y); simd::store(oz, o.z);
+        simd::store(nx, n.x); simd::store(ny, n.y); simd::store(nz, n.z);
+        cells.clear();
+        for (u64 r = 0; r < SIMD_FLOATS; ++r)
+        {
+            const f32 origin[3] = { ox[r], oy[r], oz[r] }, dir[3] = { nx[r], ny[r], nz[r] };
+            walk_cells(*this, origin, dir, cells);
+        }
+        std::sort(cells.begin(), cells.end());
+
+        u64 count = 0;
+        for (const auto &[t, c] : cells)
+        {
+            for (u32 i = this->cell_start[c]; i < this->cell_start[c + 1]; ++i)
+            {
+                const u32 q = this->indices[i];
+                if (stamps[q] == stamp) continue;
+                stamps[q] = stamp;
+                indices[count++] = q;
+            }
+        }
+        return count;
+    }
+
+    u64 grid_cull_gaussians(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, u32 *indices)
+    {
+        if (gaussians.grid == nullptr) return cone_cull_gaussians(o, n, gaussians, indices);
+        return gaussians.grid->traverse(o, n, indices);
+    }
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+#include "rt.h"
+
+namespace vrt
+{
+    /// Uniform 3D grid over the spheres of radius `gaussian_t::support` around a set of gaussians. Every
+    /// cell lists the gaussians whose bounding box overlaps it. The lists are stored back to back in `indices`, the list
+    /// of the cell `c` starts at `cell_start[c]` and ends at `cell_start[c + 1]`.
+    struct grid_t
+    {
+        f32 lo[3] = { 0.f, 0.f, 0.f };
+        f32 cell_size[3] = { 1.f, 1.f, 1.f };
+        u32 dims[3] = { 0, 0, 0 };
+        std::vector<u32> cell_start;
+        std::vector<u32> indices;
+        u64 gaussian_count = 0;
+
+        /// Builds the grid of `gaussians` with about `cells_per_gaussian` cells per gaussian. The gaussians are counted
+        /// into and then scattered to the cells in parallel with `thread_count` threads, so that the grid can be rebuilt
+        /// every frame.
+        static grid_t build(const std::vector<gaussian_t> &gaussians, const u64 thread_count = 1, const f32 cells_per_gaussian = 1.f);
+
+        /// Walks the cells along the given rays with a 3D-DDA and collects the gaussians listed in them. The cells are
+        /// visited in the order in which the rays enter them, so the gaussians are roughly sorted front to back. Like the
+        /// other culling functions the rays extend to both sides of their origins.
+        /// \param o the origins of the rays.
+        /// \param n the directions of the rays. These should be unit vectors.
+        /// \param indices output buffer for the indices of the gaussians. It needs to hold an element per gaussian of
+        /// the grid.
+        /// \return the number of collected gaussians.
+        u64 traverse(const simd_vec4f_t &o, const simd_vec4f_t &n, u32 *indices) const;
+    };
+
+    /// Version of `cull_gaussians` that walks `gaussians.grid` instead of testing every gaussian. Falls back to
+    /// `cone_cull_gaussians` if the gaussians have no grid.
+    u64 grid_cull_gaussians(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, u32 *indices);
+};
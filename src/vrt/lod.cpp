@@ -0,0 +1,139 @@
+#include "lod.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace vrt
+{
+    /// Spreads the lower 10 bits of `v` to every third bit.
+    static inline u32 spread_bits(u32 v)
+    {
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    gaussian_t merge_gaussians(const gaussian_t *gaussians, const u64 count)
+    {
+        /// NOTE: the mass of a gaussian is proportional to magnitude * sigma_x * sigma_y * sigma_z
+        std::vector<f32> mass(count);
+        f32 total = 0.f;
+        for (u64 i = 0; i < count; ++i)
+        {
+            const gaussian_t &g = gaussians[i];
+            mass[i] = g.magnitude * g.sigma * g.sigma * g.sigma * g.scale.x * g.scale.y * g.scale.z;
+            total += mass[i];
+        }
+        const f32 total_mass = total;
+        /// gaussians without mass are merged with equal weights
+        if (total <= 0.f)
+        {
+            std::fill(mass.begin(), mass.end(), 1.f);
+            total = count;
+        }
+
+        vec4f_t mu{ .x = 0.f, .y = 0.f, .z = 0.f }, albedo{ .x = 0.f, .y = 0.f, .z = 0.f, .w = 0.f };
+        for (u64 i = 0; i < count; ++i)
+        {
+            mu = mu + gaussians[i].mu * (mass[i] / total);
+            albedo = albedo + gaussians[i].albedo * (mass[i] / total);
+        }
+        f32 variance = 0.f;
+        for (u64 i = 0; i < count; ++i)
+        {
+            const gaussian_t &g = gaussians[i];
+            const vec4f_t d = g.mu - mu;
+            const f32 own = g.sigma * g.sigma * (g.scale.x * g.scale.x + g.scale.y * g.scale.y + g.scale.z * g.scale.z) / 3.f;
+            variance += mass[i] / total * (own + (d.x * d.x + d.y * d.y + d.z * d.z) / 3.f);
+        }
+
+        const f32 sigma = std::sqrt(variance);
+        return gaussian_t{
+            .albedo = albedo,
+            .mu = mu,
+            .sigma = sigma,
+            .magnitude = total_mass / (sigma * sigma * sigma)
+        };
+    }
+
+    lod_tree_t lod_tree_t::build(const std::vector<gaussian_t> &gaussians, const u64 branching)
+    {
+        lod_tree_t tree;
+        tree.leaf_count = gaussians.size();
+        if (gaussians.empty()) return tree;
+
+        vec4f_t lo = gaussians[0].mu, hi = gaussians[0].mu;
+        for (const gaussian_t &g : gaussians)
+        {
+            lo = vec4f_t{ .x = std::min(lo.x, g.mu.x), .y = std::min(lo.y, g.mu.y), .z = std::min(lo.z, g.mu.z) };
+            hi = hi.max(g.mu);
+        }
+        const f32 extent = std::max({ hi.x - lo.x, hi.y - lo.y, hi.z - lo.z, 1e-6f });
+        std::vector<u32> codes(gaussians.size());
+        for (u64 i = 0; i < gaussians.size(); ++i)
+        {
+            const vec4f_t p = (gaussians[i].mu - lo) * (1023.f / extent);
+            codes[i] = spread_bits((u32)p.x) | (spread_bits((u32)p.y) << 1) | (spread_bits((u32)p.z) << 2);
+        }
+        std::vector<u32> order(gaussians.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](const u32 a, const u32 b) { return codes[a] < codes[b]; });
+
+        for (const u32 i : order) tree.nodes.push_back(gaussians[i]);
+        tree.first_child.assign(tree.nodes.size(), 0);
+        tree.child_count.assign(tree.nodes.size(), 0);
+
+        u64 begin = 0, end = tree.nodes.size();
+        while (end - begin > 1)
+        {
+            for (u64 i = begin; i < end; i += branching)
+            {
+                const u64 count = std::min(branching, end - i);
+                const gaussian_t parent = merge_gaussians(tree.nodes.data() + i, count);
+                tree.nodes.push_back(parent);
+                tree.first_child.push_back(i);
+                tree.child_count.push_back(count);
+            }
+            begin = end;
+            end = tree.nodes.size();
+        }
+        return tree;
+    }
+
+    std::vector<gaussian_t> lod_tree_t::cut(const camera_t &cam, const f32 min_size) const
+    {
+        std::vector<gaussian_t> selected;
+        if (this->nodes.empty()) return selected;
+
+        /// NOTE: the image plane z = 0 of the view spans [-1, 1] and the eye sits at z = -`focal_length`, so a point at the
+        /// depth d = z + `focal_length` is scaled by `focal_length` / d, see `project_gaussians`
+        const f32 pixels_per_unit = cam.w / 2.f;
+        const auto projected_size = [&](const gaussian_t &g) {
+            const glm::vec4 proj = cam.view_matrix * glm::vec4(glm::vec3(g.mu.to_glm()), 1.f);
+            const f32 depth = proj.z + cam.focal_length;
+            /// gaussians at or behind the eye are always refined
+            if (depth <= 0.f) return std::numeric_limits<f32>::max();
+            return cam.focal_length * g.max_sigma() / depth * pixels_per_unit;
+        };
+
+        std::vector<u32> stack{ (u32)this->nodes.size() - 1 };
+        while (!stack.empty())
+        {
+            const u32 i = stack.back();
+            stack.pop_back();
+            bool refine = this->child_count[i] > 0;
+            for (u32 c = this->first_child[i]; refine && c < this->first_child[i] + this->child_count[i]; ++c)
+                refine = projected_size(this->nodes[c]) >= min_size;
+            if (!refine)
+            {
+                selected.push_back(this->nodes[i]);
+                continue;
+            }
+            for (u32 c = this->first_child[i]; c < this->first_child[i] + this->child_count[i]; ++c) stack.push_back(c);
+        }
+        return selected;
+    }
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+#include "camera.h"
+
+namespace vrt
+{
+    /// Level of detail hierarchy of a set of gaussians. The leaves are the original gaussians in Morton order of their
+    /// centers, every inner node is the moment matched merge of up to `branching` consecutive nodes of the level below.
+    /// The nodes are stored level by level starting with the leaves, the children of a node are contiguous and the
+    /// last node is the root.
+    struct lod_tree_t
+    {
+        std::vector<gaussian_t> nodes;
+        /// Index of the first child and number of children of every node. Leaves have no children.
+        std::vector<u32> first_child;
+        std::vector<u32> child_count;
+        u64 leaf_count = 0;
+
+        /// Builds the hierarchy of `gaussians`.
+        static lod_tree_t build(const std::vector<gaussian_t> &gaussians, const u64 branching = 8);
+
+        /// Cuts the hierarchy for the view of `cam`. A node is replaced by its children as long as every child
+        /// projects to a standard deviation of at least `min_size` pixels, so zoomed out views select few coarse
+        /// nodes and close views the original gaussians. The selected nodes cover every leaf exactly once.
+        std::vector<gaussian_t> cut(const camera_t &cam, const f32 min_size) const;
+    };
+
+    /// Merges `count` gaussians into a single isotropic gaussian with the same mass, center of mass and mean variance
+    /// per axis. The albedo is averaged weighted by the mass of the gaussians.
+    gaussian_t merge_gaussians(const gaussian_t *gaussians, const u64 count);
+};
@@ -2,6 +2,7 @@
 #include <glm/ext/matrix_clip_space.hpp>
 #include <include/definitions.h>
 #include <glm/ext/matrix_transform.hpp>
+#include <bit>
 
 namespace vrt
 {
@@ -26,45 +27,605 @@ namespace vrt
         return D;
     }
 
-    tiles_t tile_gaussians(const f32 tw, const f32 th, const std::vector<gaussian_t> &gaussians, const glm::mat4 &view)
+    f32 cutoff_radius(const gaussian_t &g, const f32 max_error)
     {
-        std::vector<gaussians_t> tiles;
-        std::vector<glm::vec2> projected_mu;
-        std::vector<f32> projected_sigma;
-        std::vector<u64> idxs;
-        for (u64 i = 0; i < gaussians.size(); ++i)
+        /// the optical depth through the center is the weight of the error functions times their largest difference 2
+        const f32 peak = (max_albedo(g.albedo) + 1.f) * g.magnitude * g.max_sigma() * INV_SQRT_2_PI * 2.f / max_error;
+        return (peak > 1.f) ? std::sqrt(2.f * std::log(peak)) : 0.f;
+    }
+
+    void set_cutoff_radii(std::vector<gaussian_t> &gaussians, const f32 max_error)
+    {
+        for (gaussian_t &g : gaussians) g.radius = cutoff_radius(g, max_error);
+    }
+
+    /// Number of keys per task of the parallel radix sort.
+    static constexpr u64 RADIX_CHUNK = 1 << 16;
+
+    /// Sorts `keys` and applies the same permutation to `values` with a least significant digit radix sort over bytes.
+    /// Every pass counts the digits per chunk of keys and scatters the chunks in parallel with `thread_count` threads.
+    /// Passes over bytes that are equal for all keys are skipped, so the cost depends on the range of the keys.
+    static void radix_sort_pairs(std::vector<u64> &keys, std::vector<u32> &values, const u64 thread_count)
+    {
+        const u64 size = keys.size();
+        const u64 chunk = std::max(RADIX_CHUNK, (size + thread_count - 1) / std::max<u64>(thread_count, 1));
+        const u64 chunks = (size + chunk - 1) / chunk;
+        std::vector<u64> tmp_keys(size);
+        std::vector<u32> tmp_values(size);
+        std::vector<std::array<u64, 256>> offsets(chunks);
+        for (u64 shift = 0; shift < 64; shift += 8)
         {
-            const glm::vec4 proj = view * glm::vec4(glm::vec3(gaussians[i].mu.to_glm()), 1.f);
-            if (proj.z < 1.f) continue;
-            const glm::vec2 mu(proj.x/proj.z, proj.y/proj.z);
-            const f32 sigma = gaussians[i].sigma / proj.z;
-            if (sigma < 1e-5f) continue;
-            projected_mu.push_back(mu);
-            projected_sigma.push_back(sigma);
-            idxs.push_back(i);
+            parallel_chunks(size, chunk, thread_count, [&](const u64 begin, const u64 end) {
+                std::array<u64, 256> &histogram = offsets[begin / chunk];
+                histogram.fill(0);
+                for (u64 i = begin; i < end; ++i) ++histogram[keys[i] >> shift & 0xFF];
+            });
+            /// the chunks write their keys of every digit after those of the previous chunks, which keeps the sort stable
+            u64 total = 0;
+            bool skip = false;
+            for (u64 d = 0; d < 256 && !skip; ++d)
+            {
+                u64 count = 0;
+                for (u64 c = 0; c < chunks; ++c)
+                {
+                    const u64 n = offsets[c][d];
+                    offsets[c][d] = total + count;
+                    count += n;
+                }
+                skip = count == size;
+                total += count;
+            }
+            if (skip) continue;
+            parallel_chunks(size, chunk, thread_count, [&](const u64 begin, const u64 end) {
+                std::array<u64, 256> &offset = offsets[begin / chunk];
+                for (u64 i = begin; i < end; ++i)
+                {
+                    const u64 o = offset[keys[i] >> shift & 0xFF]++;
+                    tmp_keys[o] = keys[i];
+                    tmp_values[o] = values[i];
+                }
+            });
+            keys.swap(tmp_keys);
+            values.swap(tmp_values);
         }
+    }
 
-        for (f32 y = -1.f + th/2; y < 1.f; y += th)
+    /// The visible gaussians with their footprints on the image plane, their depths along the view and their indices in
+    /// the scene.
+    struct projected_gaussians_t
+    {
+        std::vector<footprint_t> footprint;
+        std::vector<f32> depth;
+        std::vector<u32> index;
+    };
+
+    /// Projects the gaussians onto the image plane z = 0 of the view as seen from the eye e at z = -`focal_length`, where
+    /// the rays of `camera_t` start. A point at the depth d = z + `focal_length` lands on `focal_length` * (x, y) / d.
+    /// The footprint of a gaussian is where the rays through the ellipsoid (x - mu)^T * A * (x - mu) <= 1 with
+    /// A = P / `gaussian_t::radius`^2 pierce the plane. A ray with the direction v meets it if the quadratic along the ray
+    /// has a real root, i.e. if v^T * (u * u^T - s * A) * v >= 0 with u = A * (e - mu) and s = (e - mu)^T * u - 1. With
+    /// v = (x, y, `focal_length`) that is a conic in the image plane, which is exact unlike the Jacobian of the
+    /// projection at mu.
+    /// The rays are lines through the eye, so the gaussians behind it are projected the same way.
+    static projected_gaussians_t project_gaussians(const std::vector<gaussian_t> &gaussians, const glm::mat4 &view, const f32 focal_length)
+    {
+        projected_gaussians_t projected;
+        for (u64 i = 0; i < gaussians.size(); ++i)
         {
-            for (f32 x = -1.f + tw/2; x < 1.f; x += tw)
+            const gaussian_t &g = gaussians[i];
+            if (g.radius <= 0.f) continue;
+            const glm::vec4 proj = view * glm::vec4(glm::vec3(g.mu.to_glm()), 1.f);
+
+            /// NOTE: the conics of small distant gaussians are differences of nearly equal terms, hence the doubles
+            const std::array<f32, 6> P = g.precision();
+            const f64 W[3][3] = { { P[0], P[1], P[2] }, { P[1], P[3], P[4] }, { P[2], P[4], P[5] } };
+            const f64 inv_r2 = 1. / ((f64)g.radius * g.radius);
+            f64 A[3][3];
+            for (u64 r = 0; r < 3; ++r)
             {
-                tiles.push_back(gaussians_t());
-                gaussians_t &gs = tiles.back();
-                for (u64 i = 0; i < idxs.size(); ++i)
+                for (u64 c = 0; c < 3; ++c)
                 {
-                    const glm::vec2 &mu = projected_mu[i];
-                    const f32 &sigma = projected_sigma[i];
-                    const glm::vec2 p = glm::abs(glm::vec2(x, y) - mu);
-                    if ((p.x <= std::abs(x) + tw/2 + 3.3f * sigma
-                                && p.y <= std::abs(y) + th/2 + 3.3f * sigma))
-                    {
-                        gs.gaussians.push_back(gaussians[idxs[i]]);
-                    }
+                    A[r][c] = 0.;
+                    for (u64 k = 0; k < 3; ++k)
+                        for (u64 l = 0; l < 3; ++l)
+                            A[r][c] += (f64)view[k][r] * W[k][l] * view[l][c];
+                    A[r][c] *= inv_r2;
                 }
-                gs.soa_gaussians = gaussian_vec_t::from_gaussians(gs.gaussians);
             }
+            const f64 w[3] = { -proj.x, -proj.y, -focal_length - proj.z };
+            f64 u[3];
+            for (u64 r = 0; r < 3; ++r) u[r] = A[r][0] * w[0] + A[r][1] * w[1] + A[r][2] * w[2];
+            const f64 s = u[0] * w[0] + u[1] * w[1] + u[2] * w[2] - 1.;
+            auto M = [&](const u64 r, const u64 c) { return u[r] * u[c] - s * A[r][c]; };
+
+            /// the footprint is the ellipse (p - c)^T * B * (p - c) <= k with B = -M_xy, c = f * B^-1 * M_xz,yz and
+            /// k = c^T * B * c + f^2 * M_zz. It is no ellipse if the eye lies in the ellipsoid or the ellipsoid reaches
+            /// the plane of the eye, those gaussians get a circle of radius 2 around the center, which covers the image.
+            const f64 f = focal_length;
+            const f64 bxx = -M(0, 0), bxy = -M(0, 1), byy = -M(1, 1);
+            const f64 det = bxx * byy - bxy * bxy;
+            footprint_t footprint{ .mu = glm::vec2(0.f), .conic = glm::vec3(.25f, 0.f, .25f), .extent = glm::vec2(2.f) };
+            if (s > 0. && bxx > 0. && det > 0.)
+            {
+                const f64 mx = M(0, 2), my = M(1, 2);
+                const f64 cx = f * (byy * mx - bxy * my) / det, cy = f * (bxx * my - bxy * mx) / det;
+                const f64 k = cx * (bxx * cx + bxy * cy) + cy * (bxy * cx + byy * cy) + f * f * M(2, 2);
+                if (k <= 0.) continue;
+                footprint = footprint_t{
+                    .mu = glm::vec2(cx, cy),
+                    .conic = glm::vec3(bxx / k, bxy / k, byy / k),
+                    .extent = glm::vec2(std::sqrt(k * byy / det), std::sqrt(k * bxx / det)) };
+            }
+            projected.footprint.push_back(footprint);
+            projected.depth.push_back(proj.z + focal_length);
+            projected.index.push_back(i);
         }
+        return projected;
+    }
+
+    /// Whether the footprint `f` overlaps the tile of size `size` around `center`. The quadratic form of the conic is
+    /// convex, so its minimum over the tile is the mean of `f` if the tile contains it and lies on one of the edges
+    /// otherwise. The minimum along an edge is the unconstrained one clamped to the edge.
+    static inline bool overlaps_tile(const glm::vec2 center, const glm::vec2 size, const footprint_t &f)
+    {
+        const glm::vec2 lo = center - size/2.f - f.mu, hi = center + size/2.f - f.mu;
+        if (lo.x <= 0.f && 0.f <= hi.x && lo.y <= 0.f && 0.f <= hi.y) return true;
+        const f32 a = f.conic.x, b = f.conic.y, c = f.conic.z;
+        auto q = [a, b, c](const f32 x, const f32 y) { return a * x * x + 2.f * b * x * y + c * y * y; };
+        const f32 d = std::min({
+                q(lo.x, std::clamp(-b * lo.x / c, lo.y, hi.y)), q(hi.x, std::clamp(-b * hi.x / c, lo.y, hi.y)),
+                q(std::clamp(-b * lo.y / a, lo.x, hi.x), lo.y), q(std::clamp(-b * hi.y / a, lo.x, hi.x), hi.y) });
+        return d <= 1.f;
+    }
+
+    /// Returns the first and one past the last of the tiles of width `size` around `centers` that the bounding interval
+    /// `mu` -+ `extent` of a footprint overlaps along an axis.
+    static std::pair<u64, u64> tile_range(const std::vector<f32> &centers, const f32 size, const f32 mu, const f32 extent)
+    {
+        const i64 n = centers.size();
+        if (mu + extent < -1.f || mu - extent > 1.f) return { 0, 0 };
+        auto index = [&](const f32 x) { return std::clamp<i64>(std::floor((x + 1.f) / size), 0, n - 1); };
+        return { index(mu - extent), index(mu + extent) + 1 };
+    }
+
+    /// Returns the first and one past the last column and row of the tiles in the bounding rectangle of the footprint
+    /// `f`, all 0 if it lies outside of the image. Only the tiles in it that pass `overlaps_tile` hold the gaussian.
+    static inline std::array<u32, 4> tile_rect(const std::vector<f32> &xs, const std::vector<f32> &ys, const f32 tw, const f32 th,
+            const footprint_t &f)
+    {
+        const auto [x0, x1] = tile_range(xs, tw, f.mu.x, f.extent.x);
+        const auto [y0, y1] = tile_range(ys, th, f.mu.y, f.extent.y);
+        return (x0 < x1 && y0 < y1) ? std::array<u32, 4>{ (u32)x0, (u32)x1, (u32)y0, (u32)y1 } : std::array<u32, 4>{ 0, 0, 0, 0 };
+    }
+
+    /// Bins the projected gaussians into the tiles of width `tw` and height `th` around the centers `xs` and `ys`. The
+    /// projected gaussians of the tile `t` are `values[tile_start[t]]` to `values[tile_start[t + 1] - 1]` front to back.
+    static void bin_gaussians(const projected_gaussians_t &projected, const std::vector<f32> &xs, const std::vector<f32> &ys,
+            const f32 tw, const f32 th, const u64 thread_count, std::vector<u64> &tile_start, std::vector<u32> &values)
+    {
+        /// Sorts the gaussians front to back first. The (tile, depth) keys of the overlaps then already have their depth
+        /// digits in order, so a single stable counting pass over the tile digit finishes the radix sort.
+        const u64 size = projected.index.size();
+        std::vector<u64> depth_keys(size);
+        std::vector<u32> order(size);
+        for (u64 i = 0; i < size; ++i)
+        {
+            /// flips the bits of negative depths and the sign of positive ones, so that the bits sort like the depths
+            const u32 bits = std::bit_cast<u32>(projected.depth[i]);
+            depth_keys[i] = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+            order[i] = i;
+        }
+        radix_sort_pairs(depth_keys, order, thread_count);
+
+        /// every chunk of gaussians counts its overlaps per tile and writes them after those of the previous chunks
+        const u64 tile_count = xs.size() * ys.size();
+        const u64 chunk = std::max(RADIX_CHUNK, (size + thread_count - 1) / std::max<u64>(thread_count, 1));
+        const u64 chunks = (size + chunk - 1) / chunk;
+        std::vector<std::array<u32, 4>> ranges(size);
+        std::vector<std::vector<u64>> offsets(chunks, std::vector<u64>(tile_count, 0));
+        parallel_chunks(size, chunk, thread_count, [&](const u64 begin, const u64 end) {
+            std::vector<u64> &histogram = offsets[begin / chunk];
+            for (u64 j = begin; j < end; ++j)
+            {
+                const u32 i = order[j];
+                ranges[i] = tile_rect(xs, ys, tw, th, projected.footprint[i]);
+                for (u64 y = ranges[i][2]; y < ranges[i][3]; ++y)
+                    for (u64 x = ranges[i][0]; x < ranges[i][1]; ++x)
+                        if (overlaps_tile(glm::vec2(xs[x], ys[y]), glm::vec2(tw, th), projected.footprint[i]))
+                            ++histogram[y * xs.size() + x];
+            }
+        });
+        tile_start.assign(tile_count + 1, 0);
+        for (u64 t = 0; t < tile_count; ++t)
+        {
+            u64 count = 0;
+            for (u64 c = 0; c < chunks; ++c)
+            {
+                const u64 n = offsets[c][t];
+                offsets[c][t] = tile_start[t] + count;
+                count += n;
+            }
+            tile_start[t + 1] = tile_start[t] + count;
+        }
+        values.resize(tile_start.back());
+        parallel_chunks(size, chunk, thread_count, [&](const u64 begin, const u64 end) {
+            std::vector<u64> &offset = offsets[begin / chunk];
+            for (u64 j = begin; j < end; ++j)
+            {
+                const u32 i = order[j];
+                for (u64 y = ranges[i][2]; y < ranges[i][3]; ++y)
+                    for (u64 x = ranges[i][0]; x < ranges[i][1]; ++x)
+                        if (overlaps_tile(glm::vec2(xs[x], ys[y]), glm::vec2(tw, th), projected.footprint[i]))
+                            values[offset[y * xs.size() + x]++] = i;
+            }
+        });
+    }
+
+    /// Returns the centers of the tiles of width `size` along an axis of the image plane, accumulated in the order the
+    /// tiles are enumerated.
+    static std::vector<f32> tile_centers(const f32 size)
+    {
+        std::vector<f32> centers;
+        for (f32 c = -1.f + size/2; c < 1.f; c += size) centers.push_back(c);
+        return centers;
+    }
+
+    tiles_t tile_gaussians(const f32 tw, const f32 th, const std::vector<gaussian_t> &gaussians, const glm::mat4 &view, const f32 focal_length,
+            const u64 thread_count)
+    {
+        const projected_gaussians_t projected = project_gaussians(gaussians, view, focal_length);
+        const std::vector<f32> xs = tile_centers(tw), ys = tile_centers(th);
+        std::vector<u64> tile_start;
+        std::vector<u32> values;
+        bin_gaussians(projected, xs, ys, tw, th, thread_count, tile_start, values);
+
+        /// the gaussians of a tile are adjacent and sorted by depth, so every tile copies its range front to back
+        const u64 tile_count = xs.size() * ys.size();
+        std::vector<gaussians_t> tiles(tile_count);
+        parallel_chunks(tile_count, 16, thread_count, [&](const u64 begin, const u64 end) {
+            for (u64 t = begin; t < end; ++t)
+            {
+                gaussians_t &gs = tiles[t];
+                gs.gaussians.reserve(tile_start[t + 1] - tile_start[t]);
+                for (u64 k = tile_start[t]; k < tile_start[t + 1]; ++k)
+                    gs.gaussians.push_back(gaussians[projected.index[values[k]]]);
+                gs.soa_gaussians = gaussian_vec_t::from_gaussians(gs.gaussians);
+            }
+        });
 
         return tiles_t(tiles, tw, th);
     }
+
+    /// Replaces the gaussians of the tile `t` with the gaussians `members`, which are sorted front to back by `depths`.
+    static void fill_tile(tiles_t &tiles, const u64 t, std::vector<u32> &members, const std::vector<gaussian_t> &gaussians,
+            const std::vector<f32> &depths)
+    {
+        std::sort(members.begin(), members.end(), [&depths](const u32 a, const u32 b) { return depths[a] < depths[b]; });
+        gaussians_t &gs = tiles.gaussians[t];
+        delete gs.soa_gaussians;
+        gs.gaussians.clear();
+        for (const u32 i : members) gs.gaussians.push_back(gaussians[i]);
+        gs.soa_gaussians = gaussian_vec_t::from_gaussians(gs.gaussians);
+    }
+
+    /// Removes the gaussians of the tile `gs` with the indices `members` that fail `keep` and appends the gaussians
+    /// `added`. The AoS and SoA gaussians are patched in place, removed gaussians are replaced by the last ones. The SoA
+    /// buffers are only reallocated if the gaussians outgrow their capacity.
+    template<typename Keep>
+    static void patch_tile(gaussians_t &gs, std::vector<u32> &members, const Keep &keep, const std::vector<u32> &added,
+            const std::vector<gaussian_t> &gaussians)
+    {
+        for (u64 k = 0; k < members.size();)
+        {
+            if (keep(members[k]))
+            {
+                ++k;
+                continue;
+            }
+            members[k] = members.back();
+            members.pop_back();
+            gs.gaussians[k] = gs.gaussians.back();
+            gs.gaussians.pop_back();
+            if (k < members.size()) gs.soa_gaussians->store(k, &gs.gaussians[k]);
+        }
+        const u64 kept = members.size();
+        for (const u32 i : added)
+        {
+            members.push_back(i);
+            gs.gaussians.push_back(gaussians[i]);
+        }
+
+        if (members.size() > gs.soa_gaussians->capacity)
+        {
+            delete gs.soa_gaussians;
+            gs.soa_gaussians = gaussian_vec_t::from_gaussians(gs.gaussians);
+            return;
+        }
+        for (u64 k = kept; k < members.size(); ++k) gs.soa_gaussians->store(k, &gs.gaussians[k]);
+        gs.soa_gaussians->size = members.size();
+    }
+
+    const tiles_t &incremental_tiler_t::update(const f32 tw, const f32 th, const std::vector<gaussian_t> &gaussians,
+            const glm::mat4 &view, const f32 focal_length, const bool gaussians_changed, const u64 thread_count)
+    {
+        const projected_gaussians_t projected = project_gaussians(gaussians, view, focal_length);
+        const std::vector<f32> xs = tile_centers(tw), ys = tile_centers(th);
+        const u64 tile_count = xs.size() * ys.size();
+
+        /// the tiles of every gaussian in this frame, the depths of the gaussians that are not visible are never read
+        std::vector<std::array<u32, 4>> new_ranges(gaussians.size(), { 0, 0, 0, 0 });
+        std::vector<footprint_t> new_footprints(gaussians.size());
+        std::vector<f32> depths(gaussians.size(), 0.f);
+        for (u64 j = 0; j < projected.index.size(); ++j)
+        {
+            new_ranges[projected.index[j]] = tile_rect(xs, ys, tw, th, projected.footprint[j]);
+            new_footprints[projected.index[j]] = projected.footprint[j];
+            depths[projected.index[j]] = projected.depth[j];
+        }
+
+        auto contains = [&](const std::array<u32, 4> &r, const footprint_t &f, const u64 t) {
+            const u64 x = t % xs.size(), y = t / xs.size();
+            return r[0] <= x && x < r[1] && r[2] <= y && y < r[3] && overlaps_tile(glm::vec2(xs[x], ys[y]), glm::vec2(tw, th), f);
+        };
+
+        /// a gaussian changed if its bounding rectangle of tiles changed or its ellipse entered or left a tile in it
+        std::vector<u32> changed;
+        const bool compatible = this->tiles != nullptr && !gaussians_changed && this->tiles->tw == tw && this->tiles->th == th
+            && this->ranges.size() == gaussians.size() && this->members.size() == tile_count;
+        if (compatible)
+        {
+            for (u64 i = 0; i < gaussians.size(); ++i)
+            {
+                const std::array<u32, 4> &r = new_ranges[i];
+                bool moved = r != this->ranges[i];
+                for (u64 y = r[2]; y < r[3] && !moved; ++y)
+                    for (u64 x = r[0]; x < r[1] && !moved; ++x)
+                        moved = contains(r, new_footprints[i], y * xs.size() + x) != contains(r, this->footprints[i], y * xs.size() + x);
+                if (moved) changed.push_back(i);
+            }
+        }
+
+        this->rebuilt = !compatible || changed.size() > this->rebuild_fraction * gaussians.size();
+        if (this->rebuilt)
+        {
+            std::vector<u64> tile_start;
+            std::vector<u32> values;
+            bin_gaussians(projected, xs, ys, tw, th, thread_count, tile_start, values);
+            this->members.assign(tile_count, {});
+            this->tiles = std::make_unique<tiles_t>(std::vector<gaussians_t>(tile_count), tw, th);
+            parallel_chunks(tile_count, 16, thread_count, [&](const u64 begin, const u64 end) {
+                for (u64 t = begin; t < end; ++t)
+                {
+                    for (u64 k = tile_start[t]; k < tile_start[t + 1]; ++k)
+                        this->members[t].push_back(projected.index[values[k]]);
+                    fill_tile(*this->tiles, t, this->members[t], gaussians, depths);
+                }
+            });
+            this->ranges = std::move(new_ranges);
+            this->footprints = std::move(new_footprints);
+            this->updated_tiles = tile_count;
+            return *this->tiles;
+        }
+
+        /// only the tiles that a changed gaussian left or entered are dirty, the ones it entered also get it added
+        std::vector<u8> dirty(tile_count, 0);
+        std::vector<std::vector<u32>> added(tile_count);
+        for (const u32 i : changed)
+        {
+            const std::array<u32, 4> &o = this->ranges[i], &n = new_ranges[i];
+            const footprint_t &of = this->footprints[i], &nf = new_footprints[i];
+            for (u64 y = o[2]; y < o[3]; ++y)
+            {
+                for (u64 x = o[0]; x < o[1]; ++x)
+                {
+                    const u64 t = y * xs.size() + x;
+                    if (contains(o, of, t) && !contains(n, nf, t)) dirty[t] = 1;
+                }
+            }
+            for (u64 y = n[2]; y < n[3]; ++y)
+            {
+                for (u64 x = n[0]; x < n[1]; ++x)
+                {
+                    const u64 t = y * xs.size() + x;
+                    if (!contains(n, nf, t) || contains(o, of, t)) continue;
+                    dirty[t] = 1;
+                    added[t].push_back(i);
+                }
+            }
+        }
+        std::vector<u32> dirty_tiles;
+        for (u64 t = 0; t < tile_count; ++t)
+            if (dirty[t]) dirty_tiles.push_back(t);
+
+        parallel_chunks(dirty_tiles.size(), 16, thread_count, [&](const u64 begin, const u64 end) {
+            for (u64 d = begin; d < end; ++d)
+            {
+                const u32 t = dirty_tiles[d];
+                patch_tile(this->tiles->gaussians[t], this->members[t], [&](const u32 i) { return contains(new_ranges[i], new_footprints[i], t); },
+                        added[t], gaussians);
+            }
+        });
+        this->ranges = std::move(new_ranges);
+        this->footprints = std::move(new_footprints);
+        this->updated_tiles = dirty_tiles.size();
+        return *this->tiles;
+    }
+
+    /// Splits the tile `tile` of the quadtree over the projected gaussians `indices` until it holds at most `budget`
+    /// gaussians or can not be split any further, and appends the leaves to `leaves`. The sides of the tiles are halved
+    /// at multiples of `SIMD_FLOATS` pixels and never drop below `min_size` pixels.
+    static void split_tile(const std::vector<gaussian_t> &gaussians, const projected_gaussians_t &projected, const u64 width,
+            const u64 height, const quadtree_tile_t &tile, const std::vector<u32> &indices, const u64 budget, const u64 min_size,
+            std::vector<quadtree_tile_t> &leaves)
+    {
+        /// the offset of the split along a side of `size` pixels, or 0 if the side is not split
+        auto split = [min_size](const u64 size) -> u64 {
+            const u64 half = size / 2 / SIMD_FLOATS * SIMD_FLOATS;
+            return (half >= min_size && size - half >= min_size) ? half : 0;
+        };
+        const u64 sx = split(tile.w), sy = split(tile.h);
+        if (indices.size() <= budget || (sx == 0 && sy == 0))
+        {
+            quadtree_tile_t &leaf = leaves.emplace_back(tile);
+            leaf.gaussians.gaussians.reserve(indices.size());
+            for (const u32 i : indices) leaf.gaussians.gaussians.push_back(gaussians[projected.index[i]]);
+            leaf.gaussians.soa_gaussians = gaussian_vec_t::from_gaussians(leaf.gaussians.gaussians);
+            return;
+        }
+
+        const u64 xs[3] = { tile.x, tile.x + sx, tile.x + tile.w }, ys[3] = { tile.y, tile.y + sy, tile.y + tile.h };
+        for (u64 j = 0; j < (sy ? 2 : 1); ++j)
+        {
+            for (u64 i = 0; i < (sx ? 2 : 1); ++i)
+            {
+                const u64 x0 = sx ? xs[i] : tile.x, x1 = sx ? xs[i + 1] : tile.x + tile.w;
+                const u64 y0 = sy ? ys[j] : tile.y, y1 = sy ? ys[j + 1] : tile.y + tile.h;
+                /// NOTE: the pixel j lies at -1 + j/(width/2) on the image plane, see `camera_t::update`
+                const f32 cx = -1.f + (x0 + x1) / (f32)width, cy = -1.f + (y0 + y1) / (f32)height;
+                const f32 tw = (x1 - x0) / (width / 2.f), th = (y1 - y0) / (height / 2.f);
+                /// filtering the gaussians of the parent keeps them sorted front to back
+                std::vector<u32> child_indices;
+                for (const u32 q : indices)
+                    if (overlaps_tile(glm::vec2(cx, cy), glm::vec2(tw, th), projected.footprint[q]))
+                        child_indices.push_back(q);
+                split_tile(gaussians, projected, width, height, quadtree_tile_t{ .x = x0, .y = y0, .w = x1 - x0, .h = y1 - y0, .gaussians = {} },
+                        child_indices, budget, min_size, leaves);
+            }
+        }
+    }
+
+    quadtree_tiles_t quadtree_tile_gaussians(const f32 tw, const f32 th, const u64 width, const u64 height, const std::vector<gaussian_t> &gaussians,
+            const glm::mat4 &view, const f32 focal_length, const u64 budget, const u64 min_size, const u64 thread_count)
+    {
+        const projected_gaussians_t projected = project_gaussians(gaussians, view, focal_length);
+        const std::vector<f32> xs = tile_centers(tw), ys = tile_centers(th);
+        std::vector<u64> tile_start;
+        std::vector<u32> values;
+        bin_gaussians(projected, xs, ys, tw, th, thread_count, tile_start, values);
+
+        /// the uniform tiles are the roots, their subtrees are split in parallel into separate lists of leaves
+        const u64 tile_width = width * tw/2.f, tile_height = height * th/2.f;
+        const u64 tile_count = xs.size() * ys.size();
+        std::vector<std::vector<quadtree_tile_t>> leaves(tile_count);
+        parallel_chunks(tile_count, 1, thread_count, [&](const u64 t, const u64) {
+            const quadtree_tile_t root{ .x = (t % xs.size()) * tile_width, .y = (t / xs.size()) * tile_height, .w = tile_width, .h = tile_height, .gaussians = {} };
+            split_tile(gaussians, projected, width, height, root,
+                    std::vector<u32>(values.begin() + tile_start[t], values.begin() + tile_start[t + 1]), budget, min_size, leaves[t]);
+        });
+
+        quadtree_tiles_t tiles;
+        for (std::vector<quadtree_tile_t> &l : leaves)
+            tiles.tiles.insert(tiles.tiles.end(), std::make_move_iterator(l.begin()), std::make_move_iterator(l.end()));
+        return tiles;
+    }
+
+    /// Appends `i + l` to `indices` for every set bit `l` of `bits` that refers to one of the first `size` gaussians.
+    /// Returns the new number of indices.
+    static inline u64 compact_indices(u64 bits, const u64 i, const u64 size, u32 *indices, u64 count)
+    {
+        /// NOTE: the lanes past the last gaussian are never reported
+        if (size - i < SIMD_FLOATS) bits &= (1ull << (size - i)) - 1;
+        /// NOTE: `MAX_SIMD_WIDTH` may limit the vectors to fewer lanes than AVX-512 provides
+#if NATIVE_SIMD_WIDTH == 64
+        alignas(NATIVE_SIMD_WIDTH) static constexpr i32 lanes[SIMD_FLOATS] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+        _mm512_mask_compressstoreu_epi32(indices + count, (__mmask16)bits,
+                static_cast<__m512i>(simd::load(lanes) + simd::set1<simd::Int>(i)));
+        count += __builtin_popcountll(bits);
+#else
+        for (; bits; bits &= bits - 1)
+            indices[count++] = i + __builtin_ctzll(bits);
+#endif
+        return count;
+    }
+
+    u64 cull_gaussians(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, u32 *indices)
+    {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        f32 ox[SIMD_FLOATS], oy[SIMD_FLOATS], oz[SIMD_FLOATS], nx[SIMD_FLOATS], ny[SIMD_FLOATS], nz[SIMD_FLOATS];
+        simd::storeu(ox, o.x); simd::storeu(oy, o.y); simd::storeu(oz, o.z);
+        simd::storeu(nx, n.x); simd::storeu(ny, n.y); simd::storeu(nz, n.z);
+
+        /// the rays are tested one after another against `SIMD_FLOATS` gaussians at a time
+        u64 count = 0;
+        const u64 size = gaussians.gaussians.size();
+        for (u64 i = 0; i < size; i += SIMD_FLOATS)
+        {
+            const simd::Vec<simd::Float> mask = tail_mask(size - i);
+            const simd::Vec<simd::Float> mu_x = masked_load(g.mu.x + i, mask);
+            const simd::Vec<simd::Float> mu_y = masked_load(g.mu.y + i, mask);
+            const simd::Vec<simd::Float> mu_z = masked_load(g.mu.z + i, mask);
+            const simd::Vec<simd::Float> support = masked_load(g.support + i, mask);
+            const simd::Vec<simd::Float> radius2 = support * support;
+            simd::Vec<simd::Float> hit = simd::set1<simd::Float>(0.f);
+            for (u64 r = 0; r < SIMD_FLOATS; ++r)
+            {
+                const simd::Vec<simd::Float> dx = mu_x - simd::set1<simd::Float>(ox[r]);
+                const simd::Vec<simd::Float> dy = mu_y - simd::set1<simd::Float>(oy[r]);
+                const simd::Vec<simd::Float> dz = mu_z - simd::set1<simd::Float>(oz[r]);
+                const simd::Vec<simd::Float> mu_bar = dx * simd::set1<simd::Float>(nx[r]) + dy * simd::set1<simd::Float>(ny[r]) + dz * simd::set1<simd::Float>(nz[r]);
+                const simd::Vec<simd::Float> dist2 = dx * dx + dy * dy + dz * dz - mu_bar * mu_bar;
+                hit = simd::bit_or(hit, simd::cmplt(dist2, radius2));
+            }
+            count = compact_indices(simd::msb2int(hit), i, size, indices, count);
+        }
+        return count;
+    }
+
+    packet_cone_t packet_cone_t::from_rays(const simd_vec4f_t &o, const simd_vec4f_t &n)
+    {
+        vec4f_t axis = n.hadds();
+        axis.w = 0.f;
+        axis.normalize();
+        const f32 cos_theta = std::min(simd::hmin(n.dot(simd_vec4f_t::from_vec4f_t(axis))), 1.f);
+        f32 apex[SIMD_FLOATS];
+        packet_cone_t cone;
+        simd::storeu(apex, o.x);
+        cone.apex_x = simd::set1<simd::Float>(apex[0]);
+        simd::storeu(apex, o.y);
+        cone.apex_y = simd::set1<simd::Float>(apex[0]);
+        simd::storeu(apex, o.z);
+        cone.apex_z = simd::set1<simd::Float>(apex[0]);
+        cone.axis_x = simd::set1<simd::Float>(axis.x);
+        cone.axis_y = simd::set1<simd::Float>(axis.y);
+        cone.axis_z = simd::set1<simd::Float>(axis.z);
+        cone.cos = simd::set1<simd::Float>(cos_theta);
+        cone.sin = simd::set1<simd::Float>(std::sqrt(1.f - cos_theta * cos_theta));
+        return cone;
+    }
+
+    u64 cone_cull_gaussians(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, u32 *indices)
+    {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        const packet_cone_t cone = packet_cone_t::from_rays(o, n);
+
+        u64 count = 0;
+        const u64 size = gaussians.gaussians.size();
+        for (u64 i = 0; i < size; i += SIMD_FLOATS)
+        {
+            const simd::Vec<simd::Float> mask = tail_mask(size - i);
+            const simd::Vec<simd::Float> radius = masked_load(g.support + i, mask);
+            const simd::Vec<simd::Float> hit = cone.intersects(masked_load(g.mu.x + i, mask), masked_load(g.mu.y + i, mask),
+                    masked_load(g.mu.z + i, mask), radius);
+            count = compact_indices(simd::msb2int(hit), i, size, indices, count);
+        }
+        return count;
+    }
+
+    void temporal_accumulator_t::accumulate(u32 *image, const u64 size)
+    {
+        if (this->sum.size() != size * 4) this->frames = 0;
+        if (this->frames == 0) this->sum.assign(size * 4, 0.f);
+        ++this->frames;
+        const f32 inv_frames = 1.f / this->frames;
+        for (u64 i = 0; i < size; ++i)
+        {
+            u32 pixel = 0;
+            for (u64 c = 0; c < 4; ++c)
+            {
+                this->sum[i * 4 + c] += (image[i] >> (8 * c)) & 0xFF;
+                pixel |= (u32)std::min(this->sum[i * 4 + c] * inv_frames + .5f, 255.f) << (8 * c);
+            }
+            image[i] = pixel;
+        }
+    }
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <thread>
 #include <vector>
@@ -10,19 +12,208 @@
 #include <include/tsimd.H>
 #include <glm/glm.hpp>
 #include <numbers>
+#include <array>
 
 #define PRINT_MAT(V) fmt::print("{} {} {} {}\n{} {} {} {}\n{} {} {} {}\n{} {} {} {}\n", V[0].x, V[1].x, V[2].x, V[3].x, V[0].y, V[1].y, V[2].y, V[3].y, V[0].z, V[1].z, V[2].z, V[3].z, V[0].w, V[1].w, V[2].w, V[3].w);
 
 namespace vrt
 {
-    constexpr f32 SQRT_2_PI = 0.7978845608028654f;
-    constexpr f32 INV_SQRT_2_PI = 1.f/SQRT_2_PI;
-    constexpr f32 SQRT_2 = std::numbers::sqrt2_v<f32>;
+
+    /// Quadrature rules for the radiance integral of a single gaussian along a ray. With the substitution s = mu_bar + t * sigma
+    /// the integral becomes c_bar * sigma * int exp(-t^2/2) T(mu_bar + t * sigma) dt. A rule supplies the `count` nodes t as
+    /// `offsets`, sorted along the ray, and the `weights` of the transmittance at the nodes, which include exp(-t^2/2).
+
+    /// Riemann sum with unit spacing over the front half of the gaussian. This is the rule the renderer always used.
+    struct riemann_quadrature_t
+    {
+        static constexpr u64 count = 5;
+        static constexpr std::array<f32, count> offsets = { -4.f, -3.f, -2.f, -1.f, 0.f };
+        static constexpr std::array<f32, count> weights = { 0.00033546262790251185f, 0.011108996538242306f, 0.1353352832366127f, 0.6065306597126334f, 1.f };
+    };
+
+    /// Three point Gauss-Hermite rule over the whole gaussian. It is exact if the transmittance is a polynomial of
+    /// degree five or less along the support of the gaussian.
+    struct gauss_hermite_quadrature_t
+    {
+        static constexpr u64 count = 3;
+        static constexpr std::array<f32, count> offsets = { -1.7320508075688772f, 0.f, 1.7320508075688772f };
+        static constexpr std::array<f32, count> weights = { 0.4177713791176032f, 1.6710855164704129f, 0.4177713791176032f };
+    };
+
+    /// Riemann sum with unit spacing over the whole gaussian, i.e. `riemann_quadrature_t` continued past the center.
+    struct symmetric_quadrature_t
+    {
+        static constexpr u64 count = 9;
+        static constexpr std::array<f32, count> offsets = { -4.f, -3.f, -2.f, -1.f, 0.f, 1.f, 2.f, 3.f, 4.f };
+        static constexpr std::array<f32, count> weights = { 0.00033546262790251185f, 0.011108996538242306f, 0.1353352832366127f, 0.6065306597126334f, 1.f,
+            0.6065306597126334f, 0.1353352832366127f, 0.011108996538242306f, 0.00033546262790251185f };
+    };
+    /// Weight `sigma * c_bar / sqrt(2/pi)` below which a gaussian is considered to not intersect a ray.
+    constexpr f32 MIN_WEIGHT = 1e-6f;
+    /// Error per color channel that neglecting a single gaussian may cause by default, half of the last bit of the 8 bit
+    /// output. See `cutoff_radius`.
+    constexpr f32 CUTOFF_ERROR = .5f / 255.f;
+    /// Transmittance below which a ray is considered opaque by `front_to_back_broadcast_radiance`.
+    constexpr f32 TERMINATION_EPSILON = 1e-3f;
+
+    /// Indices 0, 1, ..., `SIMD_FLOATS` - 1 of the lanes of a vector.
+    alignas(NATIVE_SIMD_WIDTH) inline constexpr std::array<f32, SIMD_FLOATS> LANE_INDEX = [] {
+        std::array<f32, SIMD_FLOATS> idxs{};
+        for (u64 l = 0; l < SIMD_FLOATS; ++l) idxs[l] = l;
+        return idxs;
+    }();
+
+    /// Mask of the lanes of a vector that hold one of the `remaining` elements starting at its first lane. All lanes are
+    /// set once `remaining` reaches `SIMD_FLOATS`, so only the last vector of a buffer masks its tail.
+    inline simd::Vec<simd::Float> tail_mask(const u64 remaining)
+    {
+        return simd::cmplt(simd::load(LANE_INDEX.data()), simd::set1<simd::Float>(remaining));
+    }
+
+    /// Loads the vector at `p` with the lanes outside of `mask` set to zero. The masked lanes are not read, so the
+    /// buffers of `gaussian_vec_t` need not extend past their last gaussian. A gaussian loaded this way has a weight of
+    /// zero and keeps every intermediate value finite.
+    inline simd::Vec<simd::Float> masked_load(const f32 *p, const simd::Vec<simd::Float> &mask)
+    {
+        return simd::maskz_load(simd::Mask<simd::Float>(mask), p);
+    }
+
+    /// Settings and statistics of the adaptive quadrature of `adaptive_radiance`.
+    struct adaptive_quadrature_t
+    {
+        /// Maximum error of the contribution of a single gaussian to a color channel of a pixel.
+        f32 tolerance = 1e-4f;
+        /// Number of transmittance evaluations and of intersecting pairs of gaussians and rays since the last reset.
+        std::atomic<u64> samples = 0, pairs = 0;
+
+        void reset()
+        {
+            this->samples = 0;
+            this->pairs = 0;
+        }
+    };
+    inline adaptive_quadrature_t adaptive_quadrature;
+
+    /// Pixels of a packet of `width` x `SIMD_FLOATS / width` rays whose top left ray belongs to the pixel `first` of an
+    /// image with `stride` pixels per row.
+    struct pixel_packet_t
+    {
+        u64 first = 0;
+        u64 stride = SIMD_FLOATS;
+        u64 width = SIMD_FLOATS;
+
+        /// Returns the pixel of the ray in the lane `lane`.
+        inline u64 pixel(const u64 lane) const
+        {
+            return this->first + (lane / this->width) * this->stride + lane % this->width;
+        }
+    };
+
+    /// Settings of the stochastic transmittance estimator of `stochastic_broadcast_radiance`.
+    struct stochastic_transmittance_t
+    {
+        /// Expected number of correction estimates per transmittance. Larger values reduce the variance.
+        f32 lambda = 1.f;
+        /// Seed of the random numbers. Equal seeds render equal images.
+        u32 frame = 0;
+        /// The pixels of the packet that the calling thread renders. The renderers set it per packet so that every ray
+        /// draws its own random numbers.
+        static inline thread_local pixel_packet_t packet;
+    };
+    inline stochastic_transmittance_t stochastic_transmittance;
+
+    /// Settings and statistics of the culling of negligible samples. The transmittance is at most one, so the samples of a
+    /// gaussian add at most c_bar * sigma * sum |w_k| * max(albedo) to the radiance along a ray. The transmittance is not
+    /// evaluated for gaussians whose bound stays below `threshold` / N on all rays of a packet, which changes the radiance
+    /// by less than `threshold` in total. A `threshold` of zero disables the culling. It is disabled by default so that
+    /// the kernels compute the reference, renderers opt in by setting `threshold`.
+    struct sample_culling_t
+    {
+        f32 threshold = 0.f;
+        /// Number of gaussian and ray packet pairs and of the skipped ones since the last reset.
+        std::atomic<u64> pairs = 0, skipped = 0;
+        /// NOTE: the kernels count into the counters of their thread instead of `pairs` and `skipped`, so that the threads
+        /// do not contend on them per packet. The renderers merge them once per tile, see `flush`.
+        struct counts_t
+        {
+            u64 pairs, skipped;
+        };
+        static inline thread_local counts_t local;
+
+        void reset()
+        {
+            this->pairs = 0;
+            this->skipped = 0;
+        }
+
+        /// Returns the bound of c_bar * sigma * max(albedo) below which a gaussian out of `size` gaussians is skipped.
+        template<typename Quadrature>
+        f32 cutoff(const u64 size) const
+        {
+            f32 sum = 0.f;
+            for (const f32 w : Quadrature::weights) sum += fabsf(w);
+            return this->threshold / (sum * std::max<u64>(size, 1));
+        }
+
+        void count(const u64 pairs, const u64 skipped)
+        {
+            local.pairs += pairs;
+            local.skipped += skipped;
+        }
+
+        /// Adds the counts of the calling thread to `pairs` and `skipped`.
+        void flush()
+        {
+            if (local.pairs == 0) return;
+            this->pairs += local.pairs;
+            this->skipped += local.skipped;
+            local = counts_t{};
+        }
+    };
+    inline sample_culling_t sample_culling;
+
+    /// Returns the largest channel of `albedo`. The kernels accumulate the alpha channel `w` like the colors, so it counts
+    /// as well.
+    inline f32 max_albedo(const vec4f_t &albedo)
+    {
+        return std::max({ albedo.x, albedo.y, albedo.z, albedo.w });
+    }
+
+    /// Small counter based random number generator (splitmix64). Equal seeds produce equal sequences.
+    struct rng_t
+    {
+        u64 state;
+
+        u64 next()
+        {
+            u64 z = (this->state += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        /// Uniformly distributed in [0, 1).
+        f32 uniform()
+        {
+            return (this->next() >> 40) * 0x1p-24f;
+        }
+
+        /// Poisson distributed with mean `lambda`.
+        u64 poisson(const f32 lambda)
+        {
+            const f32 limit = expf(-lambda);
+            u64 k = 0;
+            for (f32 p = this->uniform(); p > limit; p *= this->uniform()) ++k;
+            return k;
+        }
+    };
 
     typedef f32(*f32_func_t)(f32);
     typedef simd::Vec<simd::Float>(*simd_f32_func_t)(simd::Vec<simd::Float>);
     typedef vec4f_t(*radiance_func_t)(const vec4f_t, const vec4f_t, const gaussians_t&);
     typedef f32(*transmittance_func_t)(const vec4f_t, const vec4f_t, const f32, const gaussians_t&);
+    typedef simd_vec4f_t(*broadcast_radiance_func_t)(const simd_vec4f_t, const simd_vec4f_t, const gaussians_t&);
+    typedef u64(*cull_func_t)(const simd_vec4f_t&, const simd_vec4f_t&, const gaussians_t&, u32*);
 
     /// Calculates the transmittance at point s*n + o for the given gaussians.
     /// \param o the origin of the ray.
@@ -61,35 +252,28 @@ namespace vrt
     template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, f32_func_t Expf = expf>
     f32 simd_transmittance(const vec4f_t _o, const vec4f_t _n, const f32 s, const gaussians_t &gaussians)
     {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        const simd_vec4f_t o = simd_vec4f_t::from_vec4f_t(_o);
+        const simd_vec4f_t n = simd_vec4f_t::from_vec4f_t(_n);
+        const u64 size = gaussians.gaussians.size();
         simd::Vec<simd::Float> T = simd::set1<simd::Float>(0.f);
-        for (u64 i = 0; i < gaussians.gaussians.size(); i += SIMD_FLOATS)
+        for (u64 i = 0; i < size; i += SIMD_FLOATS)
         {
-            simd_gaussian_t g_q{
-                .albedo{},
-                    .mu{ .x = simd::load(gaussians.soa_gaussians->mu.x + i),
-                        .y = simd::load(gaussians.soa_gaussians->mu.y + i),
-                        .z = simd::load(gaussians.soa_gaussians->mu.z + i) },
-                    .sigma = simd::load(gaussians.soa_gaussians->sigma + i),
-                    .magnitude = simd::load(gaussians.soa_gaussians->magnitude + i)
-            };
-            simd_vec4f_t o = simd_vec4f_t::from_vec4f_t(_o);
-            simd_vec4f_t n = simd_vec4f_t::from_vec4f_t(_n);
-
-            const simd_vec4f_t origin_to_center = g_q.mu - o;
-            const simd::Vec<simd::Float> inv_2_sigma2 = simd::rcp(simd::set1<simd::Float>(2.f) * g_q.sigma * g_q.sigma);
+            const simd::Vec<simd::Float> mask = tail_mask(size - i);
+            const simd_vec4f_t mu{ .x = masked_load(g.mu.x + i, mask), .y = masked_load(g.mu.y + i, mask), .z = masked_load(g.mu.z + i, mask) };
+            const simd_vec4f_t origin_to_center = mu - o;
             const simd::Vec<simd::Float> mu_bar = (origin_to_center).dot(n);
             const simd::Vec<simd::Float> oc_sqnorm = origin_to_center.sqnorm();
             const simd::Vec<simd::Float> mb2 = mu_bar * mu_bar;
             const simd::Vec<simd::Float> oc_sqnorm_diff_mb2 = oc_sqnorm - mb2;
-            const simd::Vec<simd::Float> c_bar = g_q.magnitude * Exp(-(oc_sqnorm_diff_mb2 * inv_2_sigma2));
-
-            const simd::Vec<simd::Float> sqrt_2_sig = simd::set1<simd::Float>(SQRT_2) * g_q.sigma;
+            const simd::Vec<simd::Float> weight = masked_load(g.weight_scale + i, mask) * Exp(-(oc_sqnorm_diff_mb2 * masked_load(g.inv_2_sigma2 + i, mask)));
 
-            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * simd::rcp(sqrt_2_sig);
-            const simd::Vec<simd::Float> s_sqrt_2_sig = simd::set1<simd::Float>(s) * simd::rcp(sqrt_2_sig);
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = masked_load(g.inv_sqrt_2_sigma + i, mask);
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * inv_sqrt_2_sig;
+            const simd::Vec<simd::Float> s_sqrt_2_sig = simd::set1<simd::Float>(s) * inv_sqrt_2_sig;
             const simd::Vec<simd::Float> erf1 = Erf(-mu_bar_sqrt_2_sig);
             const simd::Vec<simd::Float> erf2 = Erf(s_sqrt_2_sig-mu_bar_sqrt_2_sig);
-            T += g_q.sigma * c_bar * simd::set1<simd::Float>(INV_SQRT_2_PI) * (erf1 - erf2);
+            T += weight * (erf1 - erf2);
         }
         return Expf(simd::hadds(T));
     }
@@ -100,131 +284,1358 @@ namespace vrt
     /// \param s points along the rays.
     /// \param gaussinas the set of gaussians to compute the transmittance for.
     template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
-    simd::Vec<simd::Float> broadcast_transmittance(const simd_vec4f_t &o, const simd_vec4f_t &n, const simd::Vec<simd::Float> &s, const gaussians_t &gaussians)
+    simd::Vec<simd::Float> broadcast_transmittance(const simd_vec4f_t &o, const simd_vec4f_t &n, const simd::Vec<simd::Float> &s, const gaussians_t &gaussians)
+    {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        simd::Vec<simd::Float> T = simd::set1<simd::Float>(0.f);
+        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        {
+            const simd_vec4f_t mu{ .x = simd::set1<simd::Float>(g.mu.x[i]), .y = simd::set1<simd::Float>(g.mu.y[i]), .z = simd::set1<simd::Float>(g.mu.z[i]) };
+            const simd_vec4f_t origin_to_center = mu - o;
+            const simd::Vec<simd::Float> mu_bar = (origin_to_center).dot(n);
+            const simd::Vec<simd::Float> mb2 = mu_bar * mu_bar;
+            const simd::Vec<simd::Float> oc_sqnorm = origin_to_center.sqnorm();
+            const simd::Vec<simd::Float> oc_sqnorm_diff_mb2 = oc_sqnorm - mb2;
+            const simd::Vec<simd::Float> weight = simd::set1<simd::Float>(g.weight_scale[i])
+                * Exp( -(oc_sqnorm_diff_mb2 * simd::set1<simd::Float>(g.inv_2_sigma2[i])) );
+
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::set1<simd::Float>(g.inv_sqrt_2_sigma[i]);
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * inv_sqrt_2_sig;
+            const simd::Vec<simd::Float> s_sqrt_2_sig = s * inv_sqrt_2_sig;
+            const simd::Vec<simd::Float> erf1 = Erf(-mu_bar_sqrt_2_sig);
+            const simd::Vec<simd::Float> erf2 = Erf(s_sqrt_2_sig - mu_bar_sqrt_2_sig);
+            T += weight * (erf1 - erf2);
+        }
+        return Exp(T);
+    }
+
+    /// Version of `simd_transmittance` that evaluates the transmittance at all points in `s` in a single pass over
+    /// the gaussians. Everything but the second error function is shared between the samples.
+    /// \param o the origin of the ray.
+    /// \param n the direction of the ray. This should be a unit vector.
+    /// \param s points along the ray to sample.
+    /// \param gaussians the set of gaussians to compute the transmittance for.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, f32_func_t Expf = expf, u64 K>
+    std::array<f32, K> fused_simd_transmittance(const vec4f_t _o, const vec4f_t _n, const std::array<f32, K> &s, const gaussians_t &gaussians)
+    {
+        const simd_vec4f_t o = simd_vec4f_t::from_vec4f_t(_o);
+        const simd_vec4f_t n = simd_vec4f_t::from_vec4f_t(_n);
+        const u64 size = gaussians.gaussians.size();
+        std::array<simd::Vec<simd::Float>, K> T;
+        T.fill(simd::set1<simd::Float>(0.f));
+        for (u64 i = 0; i < size; i += SIMD_FLOATS)
+        {
+            const simd::Vec<simd::Float> mask = tail_mask(size - i);
+            const simd_vec4f_t mu{ .x = masked_load(gaussians.soa_gaussians->mu.x + i, mask),
+                .y = masked_load(gaussians.soa_gaussians->mu.y + i, mask),
+                .z = masked_load(gaussians.soa_gaussians->mu.z + i, mask) };
+
+            const simd_vec4f_t origin_to_center = mu - o;
+            const simd::Vec<simd::Float> mu_bar = (origin_to_center).dot(n);
+            const simd::Vec<simd::Float> oc_sqnorm = origin_to_center.sqnorm();
+            const simd::Vec<simd::Float> weight = masked_load(gaussians.soa_gaussians->weight_scale + i, mask)
+                * Exp(-((oc_sqnorm - mu_bar * mu_bar) * masked_load(gaussians.soa_gaussians->inv_2_sigma2 + i, mask)));
+
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = masked_load(gaussians.soa_gaussians->inv_sqrt_2_sigma + i, mask);
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * inv_sqrt_2_sig;
+            const simd::Vec<simd::Float> erf1 = Erf(-mu_bar_sqrt_2_sig);
+            for (u64 k = 0; k < K; ++k)
+            {
+                const simd::Vec<simd::Float> erf2 = Erf(simd::set1<simd::Float>(s[k]) * inv_sqrt_2_sig - mu_bar_sqrt_2_sig);
+                T[k] += weight * (erf1 - erf2);
+            }
+        }
+        std::array<f32, K> res;
+        for (u64 k = 0; k < K; ++k) res[k] = Expf(simd::hadds(T[k]));
+        return res;
+    }
+
+    /// Version of `broadcast_transmittance` that evaluates the transmittance at all points in `s` in a single pass over
+    /// the gaussians. Everything but the second error function is shared between the samples.
+    /// \param o origins of the rays.
+    /// \param n directions of the rays. These should be unit vectors.
+    /// \param s points along the rays to sample.
+    /// \param gaussians the set of gaussians to compute the transmittance for.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, u64 K>
+    std::array<simd::Vec<simd::Float>, K> fused_broadcast_transmittance(const simd_vec4f_t &o, const simd_vec4f_t &n,
+            const std::array<simd::Vec<simd::Float>, K> &s, const gaussians_t &gaussians)
+    {
+        std::array<simd::Vec<simd::Float>, K> T;
+        T.fill(simd::set1<simd::Float>(0.f));
+        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        {
+            const simd_vec4f_t mu{ .x = simd::set1<simd::Float>(gaussians.soa_gaussians->mu.x[i]),
+                .y = simd::set1<simd::Float>(gaussians.soa_gaussians->mu.y[i]),
+                .z = simd::set1<simd::Float>(gaussians.soa_gaussians->mu.z[i]) };
+
+            const simd_vec4f_t origin_to_center = mu - o;
+            const simd::Vec<simd::Float> mu_bar = (origin_to_center).dot(n);
+            const simd::Vec<simd::Float> oc_sqnorm = origin_to_center.sqnorm();
+            const simd::Vec<simd::Float> weight = simd::set1<simd::Float>(gaussians.soa_gaussians->weight_scale[i])
+                * Exp(-((oc_sqnorm - mu_bar * mu_bar) * simd::set1<simd::Float>(gaussians.soa_gaussians->inv_2_sigma2[i])));
+
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::set1<simd::Float>(gaussians.soa_gaussians->inv_sqrt_2_sigma[i]);
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * inv_sqrt_2_sig;
+            const simd::Vec<simd::Float> erf1 = Erf(-mu_bar_sqrt_2_sig);
+            for (u64 k = 0; k < K; ++k)
+            {
+                const simd::Vec<simd::Float> erf2 = Erf(s[k] * inv_sqrt_2_sig - mu_bar_sqrt_2_sig);
+                T[k] += weight * (erf1 - erf2);
+            }
+        }
+        for (u64 k = 0; k < K; ++k) T[k] = Exp(T[k]);
+        return T;
+    }
+
+    /// Numerical approximation of the transmittance.
+    f32 transmittance_step(const vec4f_t o, const vec4f_t n, const f32 s, const f32 delta, const std::vector<gaussian_t> gaussians);
+
+    /// Returns the combined density at point `pt` for the given set of gaussians.
+    f32 density(const vec4f_t pt, const std::vector<gaussian_t> gaussians);
+
+    /// Returns the distance in standard deviations beyond which neglecting the gaussian `g` changes no color channel by
+    /// more than `max_error`. A ray that passes the gaussian at r standard deviations integrates an optical depth of at
+    /// most tau = magnitude * sigma * sqrt(2 pi) * exp(-r^2/2) over it, with the largest standard deviation sigma. The
+    /// ray loses at most albedo * tau of the light of the gaussian itself and the transmittance of everything behind it
+    /// changes by a factor of at most exp(tau), so the error is at most (albedo + 1) * tau to first order. Gaussians that
+    /// stay below `max_error` everywhere get a radius of 0. The bound holds per neglected gaussian, rays that pass many of
+    /// them can accumulate their errors.
+    f32 cutoff_radius(const gaussian_t &g, const f32 max_error = CUTOFF_ERROR);
+
+    /// Sets the `radius` of all `gaussians` to their `cutoff_radius`. This only needs to be repeated if the gaussians
+    /// change.
+    void set_cutoff_radii(std::vector<gaussian_t> &gaussians, const f32 max_error = CUTOFF_ERROR);
+
+    /// The ellipse of the image plane whose rays pass a gaussian within `gaussian_t::radius` standard deviations. The
+    /// ellipse is the set of points p with (p - mu)^T * conic * (p - mu) <= 1, where `conic` is packed as xx, xy, yy, and
+    /// it reaches up to `extent` from `mu` along the axes.
+    struct footprint_t
+    {
+        glm::vec2 mu{ 0.f };
+        glm::vec3 conic{ 0.f };
+        glm::vec2 extent{ 0.f };
+    };
+
+    /// Separate the given gaussians into sets based on which tiles of the image they affect. Every gaussian is projected
+    /// onto the ellipse of the rays that pass it within its cutoff radius and emits a key per tile in its bounding
+    /// rectangle that the ellipse overlaps. The keys are radix sorted by tile and depth and every tile takes its range of the keys.
+    /// The cost grows with the number of overlaps instead of the number of tiles times gaussians, and the gaussians of
+    /// every tile are sorted front to back.
+    /// \param tw width of the image tiles.
+    /// \param th height of the image tiles.
+    /// \param gaussians the set of gaussians to separate.
+    /// \param view the view matrix of the scene.
+    /// \param focal_length the distance of the eye to the image plane, see `camera_t`.
+    /// \param thread_count number of threads that emit and sort the keys and fill the tiles.
+    tiles_t tile_gaussians(const f32 tw, const f32 th, const std::vector<gaussian_t> &gaussians, const glm::mat4 &view, const f32 focal_length,
+            const u64 thread_count = 1);
+
+    /// Keeps the tiles of `tile_gaussians` across frames. Every update projects the gaussians again, but only the
+    /// gaussians that entered or left a tile since the last frame are removed from or appended to it in place, so the
+    /// cost of small camera motions grows with the number of changes. The tiles hold the same gaussians as those of
+    /// `tile_gaussians`, but they are only sorted front to back right after a full rebuild.
+    struct incremental_tiler_t
+    {
+        /// Share of the gaussians whose tiles may change before all tiles are rebuilt from scratch.
+        f32 rebuild_fraction = 0.25f;
+        /// Number of tiles that the last update changed and whether it rebuilt all of them.
+        u64 updated_tiles = 0;
+        bool rebuilt = false;
+
+        std::unique_ptr<tiles_t> tiles;
+        /// The first and one past the last column and row of the bounding rectangle of tiles of every gaussian, all 0 if
+        /// it is not visible, and the footprints that pick its tiles out of the rectangle.
+        std::vector<std::array<u32, 4>> ranges;
+        std::vector<footprint_t> footprints;
+        /// The indices of the gaussians of every tile.
+        std::vector<std::vector<u32>> members;
+
+        /// Updates the tiles to the given gaussians and view and returns them. The tiles are rebuilt from scratch if
+        /// `gaussians_changed` is set or the number or size of the tiles changed.
+        /// \param thread_count number of threads that bin the gaussians and rebuild the tiles.
+        const tiles_t &update(const f32 tw, const f32 th, const std::vector<gaussian_t> &gaussians, const glm::mat4 &view,
+                const f32 focal_length, const bool gaussians_changed, const u64 thread_count = 1);
+    };
+
+    /// Separates the given gaussians into variable size tiles. The uniform tiles of `tile_gaussians` are the roots of a
+    /// quadtree per tile, and every tile with more than `budget` gaussians is split into halves along both sides until its
+    /// sides reach `min_size` pixels. Dense regions of the image get small tiles with short lists of gaussians while sparse
+    /// regions keep large tiles.
+    /// \param tw width of the uniform tiles.
+    /// \param th height of the uniform tiles.
+    /// \param width the width of the image in pixels.
+    /// \param height the height of the image in pixels.
+    /// \param gaussians the set of gaussians to separate.
+    /// \param view the view matrix of the scene.
+    /// \param focal_length the distance of the eye to the image plane, see `camera_t`.
+    /// \param budget the number of gaussians above which a tile is split.
+    /// \param min_size the smallest side of a tile in pixels. This needs to be a multiple of `SIMD_FLOATS`.
+    /// \param thread_count number of threads that bin the gaussians and split the uniform tiles.
+    quadtree_tiles_t quadtree_tile_gaussians(const f32 tw, const f32 th, const u64 width, const u64 height, const std::vector<gaussian_t> &gaussians,
+            const glm::mat4 &view, const f32 focal_length, const u64 budget, const u64 min_size = SIMD_FLOATS, const u64 thread_count = 1);
+
+    /// Collects the gaussians whose perpendicular distance to at least one of the given rays is within
+    /// `gaussian_t::support`. The remaining gaussians have a negligible density along all of the rays, see `cutoff_radius`.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to test.
+    /// \param indices output buffer for the indices of the intersecting gaussians. It needs to hold
+    /// `gaussians.soa_gaussians->size` elements.
+    /// \return the number of intersecting gaussians.
+    u64 cull_gaussians(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, u32 *indices);
+
+    /// Version of `cull_gaussians` that tests the gaussians once against a cone bounding all of the rays instead of
+    /// against every ray. The rays need to share their origin. The more coherent the rays, the tighter the cone.
+    u64 cone_cull_gaussians(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, u32 *indices);
+
+    /// Double cone around a packet of rays with a common origin that contains all of the rays. Like the rays it extends
+    /// to both sides of the apex, since the samples of a gaussian close to the origin may lie behind it.
+    struct packet_cone_t
+    {
+        simd::Vec<simd::Float> apex_x, apex_y, apex_z;
+        simd::Vec<simd::Float> axis_x, axis_y, axis_z;
+        simd::Vec<simd::Float> cos, sin;
+
+        /// Returns the tightest cone around the mean direction of the rays.
+        static packet_cone_t from_rays(const simd_vec4f_t &o, const simd_vec4f_t &n);
+
+        /// Returns the mask of the spheres with the centers (`x`, `y`, `z`) and radii `radius` that intersect the cone.
+        inline simd::Vec<simd::Float> intersects(const simd::Vec<simd::Float> &x, const simd::Vec<simd::Float> &y,
+                const simd::Vec<simd::Float> &z, const simd::Vec<simd::Float> &radius) const
+        {
+            const simd::Vec<simd::Float> dx = x - this->apex_x;
+            const simd::Vec<simd::Float> dy = y - this->apex_y;
+            const simd::Vec<simd::Float> dz = z - this->apex_z;
+            const simd::Vec<simd::Float> along = dx * this->axis_x + dy * this->axis_y + dz * this->axis_z;
+            const simd::Vec<simd::Float> across = simd::sqrt(simd::max(dx * dx + dy * dy + dz * dz - along * along, simd::set1<simd::Float>(0.f)));
+            /// distance of the center to the surface of the cone
+            const simd::Vec<simd::Float> dist = across * this->cos - simd::abs(along) * this->sin;
+            return simd::cmple(dist, radius);
+        }
+    };
+
+    /// Running mean of consecutive frames of a stochastic renderer. It converges the noise while the scene and the camera
+    /// stay the same and needs to be reset whenever they change.
+    struct temporal_accumulator_t
+    {
+        std::vector<f32> sum;
+        u64 frames = 0;
+
+        void reset() { this->frames = 0; }
+
+        /// Adds `image` to the running sum and replaces it with the mean of all frames since the last reset.
+        void accumulate(u32 *image, const u64 size);
+    };
+
+    /// Approximates the radiance integral L along the given ray o + s*n.
+    /// \param o the origin of the ray.
+    /// \param n the direction of the ray. This should be a unit vector.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<transmittance_func_t Tr = simd_transmittance, typename Quadrature = riemann_quadrature_t>
+    vec4f_t radiance(const vec4f_t o, const vec4f_t n, const gaussians_t &gaussians)
+    {
+        vec4f_t L_hat{ .x = 0.f, .y = 0.f, .z = 0.f };
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(gaussians.gaussians.size());
+        u64 skipped = 0;
+        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        {
+            const gaussian_t &G_q = gaussians.gaussians[i];
+            const f32 lambda_q = G_q.sigma;
+            const f32 mu_bar = (G_q.mu - o).dot(n);
+            /// NOTE: the weights of the rule include the shape of the density, only its value at the center is needed
+            const f32 c_bar = G_q.pdf(o + (n * mu_bar));
+            if (c_bar * lambda_q * max_albedo(G_q.albedo) < cutoff)
+            {
+                ++skipped;
+                continue;
+            }
+            f32 inner = 0.f;
+            for (u64 k = 0; k < Quadrature::count; ++k)
+            {
+                const f32 s = mu_bar + Quadrature::offsets[k] * lambda_q;
+                const f32 T = Tr(o, n, s, gaussians);
+                inner += Quadrature::weights[k] * c_bar * T * lambda_q;
+            }
+            L_hat = L_hat + (G_q.albedo * inner);
+        }
+        sample_culling.count(gaussians.gaussians.size(), skipped);
+        return L_hat;
+    }
+
+    /// Version of `radiance` that evaluates the transmittance at all samples of a gaussian in a single pass over the
+    /// gaussians using `fused_simd_transmittance`. The density at the samples is derived from `c_bar` analytically.
+    /// \param o the origin of the ray.
+    /// \param n the direction of the ray. This should be a unit vector.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, f32_func_t Expf = expf, typename Quadrature = riemann_quadrature_t>
+    vec4f_t fused_radiance(const vec4f_t o, const vec4f_t n, const gaussians_t &gaussians)
+    {
+        vec4f_t L_hat{ .x = 0.f, .y = 0.f, .z = 0.f };
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(gaussians.gaussians.size());
+        u64 skipped = 0;
+        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        {
+            const gaussian_t &G_q = gaussians.gaussians[i];
+            const f32 lambda_q = G_q.sigma;
+            const vec4f_t origin_to_center = G_q.mu - o;
+            const f32 mu_bar = origin_to_center.dot(n);
+            const f32 c_bar = G_q.magnitude * Expf(-(origin_to_center.sqnorm() - mu_bar * mu_bar) / (2.f * G_q.sigma * G_q.sigma));
+            if (c_bar * lambda_q * max_albedo(G_q.albedo) < cutoff)
+            {
+                ++skipped;
+                continue;
+            }
+            std::array<f32, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + Quadrature::offsets[k] * lambda_q;
+            const std::array<f32, Quadrature::count> T = fused_simd_transmittance<Exp, Erf, Expf>(o, n, s, gaussians);
+            f32 inner = 0.f;
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += Quadrature::weights[k] * T[k];
+            L_hat = L_hat + (G_q.albedo * (c_bar * lambda_q * inner));
+        }
+        sample_culling.count(gaussians.gaussians.size(), skipped);
+        return L_hat;
+    }
+
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t>
+    vec4f_t simd_radiance(const vec4f_t _o, const vec4f_t _n, const gaussians_t &gaussians)
+    {
+        const u64 size = gaussians.gaussians.size();
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(size);
+        u64 skipped = 0;
+        simd_vec4f_t L_hat{};
+        for (u64 i = 0; i < size; i += SIMD_FLOATS)
+        {
+            const simd::Vec<simd::Float> mask = tail_mask(size - i);
+            simd_gaussian_t g_q{
+                .albedo{
+                    .x = masked_load(gaussians.soa_gaussians->albedo.r + i, mask),
+                    .y = masked_load(gaussians.soa_gaussians->albedo.g + i, mask),
+                    .z = masked_load(gaussians.soa_gaussians->albedo.b + i, mask),
+                    .w = simd::set1<simd::Float>(1.f)
+                },
+                .mu{
+                    .x = masked_load(gaussians.soa_gaussians->mu.x + i, mask),
+                    .y = masked_load(gaussians.soa_gaussians->mu.y + i, mask),
+                    .z = masked_load(gaussians.soa_gaussians->mu.z + i, mask) },
+                .sigma = masked_load(gaussians.soa_gaussians->sigma + i, mask),
+                .magnitude = masked_load(gaussians.soa_gaussians->magnitude + i, mask)
+            };
+            simd_vec4f_t o = simd_vec4f_t::from_vec4f_t(_o);
+            simd_vec4f_t n = simd_vec4f_t::from_vec4f_t(_n);
+            const simd::Vec<simd::Float> lambda = g_q.sigma;
+            const simd_vec4f_t origin_to_center = g_q.mu - o;
+            const simd::Vec<simd::Float> mu_bar = origin_to_center.dot(n);
+            const simd::Vec<simd::Float> c_bar = g_q.magnitude
+                * Exp(-((origin_to_center.sqnorm() - mu_bar * mu_bar) * masked_load(gaussians.soa_gaussians->inv_2_sigma2 + i, mask)));
+            /// NOTE: the padding lanes have a magnitude of zero and never keep a vector of gaussians alive
+            if (simd::hmax(c_bar * lambda * simd::max(simd::max(g_q.albedo.x, g_q.albedo.y), g_q.albedo.z)) < cutoff)
+            {
+                skipped += std::min<u64>(SIMD_FLOATS, size - i);
+                continue;
+            }
+            std::array<simd::Vec<simd::Float>, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda;
+            const std::array<simd::Vec<simd::Float>, Quadrature::count> T = fused_broadcast_transmittance<Exp, Erf>(o, n, s, gaussians);
+            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * T[k];
+            L_hat = L_hat + (g_q.albedo * (c_bar * lambda * inner));
+        }
+        sample_culling.count(size, skipped);
+        return L_hat.hadds();
+    }
+
+    /// Version of `radiance` that operates a set of `SIMD_FLOATS` rays.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t>
+    simd_vec4f_t broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        simd_vec4f_t L_hat{ .x = simd::set1<simd::Float>(0.f), .y = simd::set1<simd::Float>(0.f), .z = simd::set1<simd::Float>(0.f), .w = simd::set1<simd::Float>(0.f) };
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(gaussians.gaussians.size());
+        u64 skipped = 0;
+        for (u64 q = 0; q < gaussians.gaussians.size(); ++q)
+        {
+            const simd_gaussian_t G_q = simd_gaussian_t::from_gaussian_t(gaussians.gaussians[q]);
+            const simd::Vec<simd::Float> lambda_q = G_q.sigma;
+            const simd_vec4f_t origin_to_center = G_q.mu - o;
+            const simd::Vec<simd::Float> mu_bar = origin_to_center.dot(n);
+            const simd::Vec<simd::Float> c_bar = G_q.magnitude
+                * Exp(-((origin_to_center.sqnorm() - mu_bar * mu_bar) * simd::set1<simd::Float>(gaussians.soa_gaussians->inv_2_sigma2[q])));
+            if (simd::hmax(c_bar * lambda_q) * max_albedo(gaussians.gaussians[q].albedo) < cutoff)
+            {
+                ++skipped;
+                continue;
+            }
+            std::array<simd::Vec<simd::Float>, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda_q;
+            const std::array<simd::Vec<simd::Float>, Quadrature::count> T = fused_broadcast_transmittance<Exp, Erf>(o, n, s, gaussians);
+            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * T[k];
+            L_hat = L_hat + (G_q.albedo * (c_bar * lambda_q * inner));
+        }
+        sample_culling.count(gaussians.gaussians.size(), skipped);
+        return L_hat;
+    }
+
+    /// Largest number of gaussians for which the tiled `simd_render_image` uses `closed_form_broadcast_radiance`.
+    constexpr u64 CLOSED_FORM_MAX_GAUSSIANS = 2;
+
+    /// Version of `broadcast_radiance` for at most `CLOSED_FORM_MAX_GAUSSIANS` gaussians. The samples of a gaussian sit at
+    /// fixed offsets from its own center, so the error functions of its own optical depth at the samples are constants
+    /// and its transmittance is exp(weight * (erf1 - erf(offset / sqrt(2)))). Only the other gaussian is evaluated at
+    /// the samples, and everything that depends on the rays is computed once per gaussian instead of once per pair.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t>
+    simd_vec4f_t closed_form_broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        static const std::array<simd::Vec<simd::Float>, Quadrature::count> self_erf = [] () {
+            std::array<simd::Vec<simd::Float>, Quadrature::count> res;
+            for (u64 k = 0; k < Quadrature::count; ++k) res[k] = Erf(simd::set1<simd::Float>(Quadrature::offsets[k] / SQRT_2));
+            return res;
+        }();
+        const u64 size = gaussians.gaussians.size();
+        ASSERT((size <= CLOSED_FORM_MAX_GAUSSIANS));
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        std::array<simd::Vec<simd::Float>, CLOSED_FORM_MAX_GAUSSIANS> mu_bar_sqrt_2_sig, c_bar, weight, erf1;
+        for (u64 q = 0; q < size; ++q)
+        {
+            const simd_vec4f_t mu{ .x = simd::set1<simd::Float>(g.mu.x[q]), .y = simd::set1<simd::Float>(g.mu.y[q]), .z = simd::set1<simd::Float>(g.mu.z[q]) };
+            const simd_vec4f_t origin_to_center = mu - o;
+            const simd::Vec<simd::Float> mu_bar = origin_to_center.dot(n);
+            const simd::Vec<simd::Float> e = Exp(-((origin_to_center.sqnorm() - mu_bar * mu_bar) * simd::set1<simd::Float>(g.inv_2_sigma2[q])));
+            mu_bar_sqrt_2_sig[q] = mu_bar * simd::set1<simd::Float>(g.inv_sqrt_2_sigma[q]);
+            c_bar[q] = simd::set1<simd::Float>(g.magnitude[q]) * e;
+            weight[q] = simd::set1<simd::Float>(g.weight_scale[q]) * e;
+            erf1[q] = Erf(-mu_bar_sqrt_2_sig[q]);
+        }
+
+        simd_vec4f_t L_hat{ .x = simd::set1<simd::Float>(0.f), .y = simd::set1<simd::Float>(0.f), .z = simd::set1<simd::Float>(0.f), .w = simd::set1<simd::Float>(0.f) };
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(size);
+        u64 skipped = 0;
+        for (u64 q = 0; q < size; ++q)
+        {
+            const simd::Vec<simd::Float> lambda_q = simd::set1<simd::Float>(g.sigma[q]);
+            if (simd::hmax(c_bar[q] * lambda_q) * max_albedo(gaussians.gaussians[q].albedo) < cutoff)
+            {
+                ++skipped;
+                continue;
+            }
+            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+            {
+                simd::Vec<simd::Float> tau = weight[q] * (erf1[q] - self_erf[k]);
+                for (u64 p = 0; p < size; ++p)
+                {
+                    if (p == q) continue;
+                    /// the sample in units of the other gaussian, i.e. s * inv_sqrt_2_sigma with s = mu_bar + offset * sigma
+                    const simd::Vec<simd::Float> s_sqrt_2_sig = (mu_bar_sqrt_2_sig[q] + simd::set1<simd::Float>(Quadrature::offsets[k] / SQRT_2))
+                        * simd::set1<simd::Float>(g.inv_sqrt_2_sigma[p] / g.inv_sqrt_2_sigma[q]);
+                    tau += weight[p] * (erf1[p] - Erf(s_sqrt_2_sig - mu_bar_sqrt_2_sig[p]));
+                }
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * Exp(tau);
+            }
+            L_hat = L_hat + (simd_vec4f_t::from_vec4f_t(gaussians.gaussians[q].albedo) * (c_bar[q] * lambda_q * inner));
+        }
+        sample_culling.count(size, skipped);
+        return L_hat;
+    }
+
+    /// Computes the quantities of `gaussians` that only depend on the rays and not on the sample distance and stores
+    /// them in `params`.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to precompute the quantities for.
+    /// \param params the scratch buffer to write into. It is grown if necessary.
+    /// \param indices the indices of the gaussians to precompute the quantities for. The quantities of the gaussian
+    /// `indices[i]` are stored at position `i`. If `nullptr` all gaussians are used in their original order.
+    /// \param count the number of gaussians to precompute the quantities for.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
+    void precompute_ray_params(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, ray_params_vec_t &params,
+            const u32 *indices, const u64 count)
+    {
+        params.reserve(count);
+        for (u64 i = 0; i < count; ++i)
+        {
+            const u64 q = indices ? indices[i] : i;
+            const gaussian_vec_t &g = *gaussians.soa_gaussians;
+            const simd_vec4f_t mu{ .x = simd::set1<simd::Float>(g.mu.x[q]), .y = simd::set1<simd::Float>(g.mu.y[q]), .z = simd::set1<simd::Float>(g.mu.z[q]) };
+            const simd_vec4f_t origin_to_center = mu - o;
+            const simd::Vec<simd::Float> mu_bar = (origin_to_center).dot(n);
+            const simd::Vec<simd::Float> mb2 = mu_bar * mu_bar;
+            const simd::Vec<simd::Float> oc_sqnorm = origin_to_center.sqnorm();
+            const simd::Vec<simd::Float> weight = simd::set1<simd::Float>(g.weight_scale[q])
+                * Exp( -((oc_sqnorm - mb2) * simd::set1<simd::Float>(g.inv_2_sigma2[q])) );
+
+            const f32 inv_sqrt_2_sig = g.inv_sqrt_2_sigma[q];
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * simd::set1<simd::Float>(inv_sqrt_2_sig);
+            simd::store(params.mu_bar + i * SIMD_FLOATS, mu_bar);
+            simd::store(params.mu_bar_sqrt_2_sigma + i * SIMD_FLOATS, mu_bar_sqrt_2_sig);
+            simd::store(params.weight + i * SIMD_FLOATS, weight);
+            simd::store(params.erf1 + i * SIMD_FLOATS, Erf(-mu_bar_sqrt_2_sig));
+            params.inv_sqrt_2_sigma[i] = inv_sqrt_2_sig;
+        }
+    }
+
+    /// Computes the quantities of all `gaussians` that only depend on the rays and not on the sample distance and stores
+    /// them in `params`.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
+    void precompute_ray_params(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, ray_params_vec_t &params)
+    {
+        precompute_ray_params<Exp, Erf>(o, n, gaussians, params, nullptr, gaussians.gaussians.size());
+    }
+
+    /// Computes the projections of `gaussians` onto the unnormalized rays through a tile of the projection plane and stores
+    /// them in `plane`, see `plane_params_vec_t`.
+    /// \param o the origin of the rays.
+    /// \param corner the point on the projection plane of the top left pixel of the tile minus `o`.
+    /// \param dx the step on the projection plane from one pixel to the next one in the same row.
+    /// \param dy the step on the projection plane from one pixel to the next one in the same column.
+    /// \param gaussians the gaussians to compute the projections for.
+    /// \param plane the scratch buffer to write into. It is grown if necessary.
+    inline void precompute_plane_params(const vec4f_t &o, const glm::vec3 &corner, const glm::vec3 &dx, const glm::vec3 &dy,
+            const gaussians_t &gaussians, plane_params_vec_t &plane)
+    {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        plane.reserve(gaussians.gaussians.size());
+        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        {
+            const glm::vec3 origin_to_center(g.mu.x[i] - o.x, g.mu.y[i] - o.y, g.mu.z[i] - o.z);
+            plane.corner[i] = glm::dot(origin_to_center, corner);
+            plane.dx[i] = glm::dot(origin_to_center, dx);
+            plane.dy[i] = glm::dot(origin_to_center, dy);
+            plane.sqnorm[i] = glm::dot(origin_to_center, origin_to_center);
+        }
+    }
+
+    /// Version of `precompute_ray_params` for the rays through the pixels at the offsets (`x`, `y`) from the corner of the
+    /// tile whose projections are stored in `plane`. mu_bar = (mu - o) . (p - o) / |p - o| where the numerator is affine
+    /// in the pixel offsets and the denominator is the same for all gaussians, so the dot products and norms per gaussian
+    /// reduce to two fused multiply adds. As the finite differences of an affine function are constant, the projections
+    /// are evaluated directly from the corner instead of being accumulated from pixel to pixel, which does not drift.
+    /// \param x the horizontal offsets of the pixels from the corner of the tile.
+    /// \param y the vertical offsets of the pixels from the corner of the tile.
+    /// \param inv_length 1 / |p - o| of the rays.
+    /// \param gaussians the gaussians to precompute the quantities for.
+    /// \param plane the projections computed by `precompute_plane_params`.
+    /// \param params the scratch buffer to write into. It is grown if necessary.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
+    void precompute_plane_ray_params(const simd::Vec<simd::Float> &x, const simd::Vec<simd::Float> &y, const simd::Vec<simd::Float> &inv_length,
+            const gaussians_t &gaussians, const plane_params_vec_t &plane, ray_params_vec_t &params)
+    {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        params.reserve(gaussians.gaussians.size());
+        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        {
+            const simd::Vec<simd::Float> mu_bar = (simd::set1<simd::Float>(plane.corner[i]) + x * simd::set1<simd::Float>(plane.dx[i])
+                    + y * simd::set1<simd::Float>(plane.dy[i])) * inv_length;
+            const simd::Vec<simd::Float> weight = simd::set1<simd::Float>(g.weight_scale[i])
+                * Exp( -((simd::set1<simd::Float>(plane.sqnorm[i]) - mu_bar * mu_bar) * simd::set1<simd::Float>(g.inv_2_sigma2[i])) );
+
+            const f32 inv_sqrt_2_sig = g.inv_sqrt_2_sigma[i];
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * simd::set1<simd::Float>(inv_sqrt_2_sig);
+            simd::store(params.mu_bar + i * SIMD_FLOATS, mu_bar);
+            simd::store(params.mu_bar_sqrt_2_sigma + i * SIMD_FLOATS, mu_bar_sqrt_2_sig);
+            simd::store(params.weight + i * SIMD_FLOATS, weight);
+            simd::store(params.erf1 + i * SIMD_FLOATS, Erf(-mu_bar_sqrt_2_sig));
+            params.inv_sqrt_2_sigma[i] = inv_sqrt_2_sig;
+        }
+    }
+
+    /// Version of `broadcast_transmittance` that reads the per-ray quantities of the gaussians from `params` instead of
+    /// recomputing them. Only the second error function has to be evaluated per gaussian and sample.
+    /// \param s points along the rays.
+    /// \param params the quantities computed by `precompute_ray_params`.
+    /// \param size the number of gaussians in `params`.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, u64 K>
+    std::array<simd::Vec<simd::Float>, K> precomputed_transmittance(const std::array<simd::Vec<simd::Float>, K> &s, const ray_params_vec_t &params, const u64 size)
+    {
+        std::array<simd::Vec<simd::Float>, K> T;
+        T.fill(simd::set1<simd::Float>(0.f));
+        for (u64 i = 0; i < size; ++i)
+        {
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::set1<simd::Float>(params.inv_sqrt_2_sigma[i]);
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = simd::load(params.mu_bar_sqrt_2_sigma + i * SIMD_FLOATS);
+            const simd::Vec<simd::Float> weight = simd::load(params.weight + i * SIMD_FLOATS);
+            const simd::Vec<simd::Float> erf1 = simd::load(params.erf1 + i * SIMD_FLOATS);
+            for (u64 k = 0; k < K; ++k)
+            {
+                const simd::Vec<simd::Float> erf2 = Erf(s[k] * inv_sqrt_2_sig - mu_bar_sqrt_2_sig);
+                T[k] += weight * (erf1 - erf2);
+            }
+        }
+        for (u64 k = 0; k < K; ++k) T[k] = Exp(T[k]);
+        return T;
+    }
+
+    /// Version of `broadcast_radiance` that computes the quantities of the gaussians that do not depend on the sample
+    /// distance once per set of rays instead of once per sample.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t>
+    simd_vec4f_t precomputed_broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local ray_params_vec_t params;
+        precompute_ray_params<Exp, Erf>(o, n, gaussians, params);
+        /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(gaussians.gaussians.size()) / SQRT_2_PI;
+        u64 skipped = 0;
+
+        simd_vec4f_t L_hat{ .x = simd::set1<simd::Float>(0.f), .y = simd::set1<simd::Float>(0.f), .z = simd::set1<simd::Float>(0.f), .w = simd::set1<simd::Float>(0.f) };
+        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        {
+            const vec4f_t &albedo = gaussians.gaussians[i].albedo;
+            if (simd::hmax(simd::load(params.weight + i * SIMD_FLOATS)) * max_albedo(albedo) < cutoff)
+            {
+                ++skipped;
+                continue;
+            }
+            const simd::Vec<simd::Float> lambda_q = simd::set1<simd::Float>(gaussians.gaussians[i].sigma);
+            const simd::Vec<simd::Float> mu_bar = simd::load(params.mu_bar + i * SIMD_FLOATS);
+            std::array<simd::Vec<simd::Float>, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda_q;
+            const std::array<simd::Vec<simd::Float>, Quadrature::count> T = precomputed_transmittance<Exp, Erf>(s, params, gaussians.gaussians.size());
+            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * T[k];
+            /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+            inner *= simd::load(params.weight + i * SIMD_FLOATS) * simd::set1<simd::Float>(SQRT_2_PI);
+            L_hat = L_hat + (simd_vec4f_t::from_vec4f_t(albedo) * inner);
+        }
+        sample_culling.count(gaussians.gaussians.size(), skipped);
+        return L_hat;
+    }
+
+    /// Number of ray packets and of query gaussians per register tile of the blocked kernels, see `blocked_erf2_sum`. With
+    /// the 5 samples of `riemann_quadrature_t` the tile and its samples take 20 of the 32 AVX-512 registers. Only
+    /// `blocked_render_image` hands several packets to each call, the kernels for single packets use one.
+    constexpr u64 BLOCKED_PACKETS = 2;
+    constexpr u64 BLOCKED_GAUSSIANS = 1;
+
+    /// Computes the quantities of all `gaussians` that only depend on the rays like `precompute_ray_params`, but for
+    /// `Packets` packets of rays with shared origins at once. The projections mu_bar = (mu - o) . n of a block of `Gaussians`
+    /// gaussians onto the rays of all packets are a `Packets` x `Gaussians` matrix product of the directions and the offsets
+    /// of the centers, which stays in registers. The offsets and their norms are computed once for all packets.
+    /// \param o the origins of the rays, shared by all packets.
+    /// \param n the directions of the rays of each packet. These should be unit vectors.
+    /// \param gaussians the gaussians to precompute the quantities for.
+    /// \param params the scratch buffers to write into, one per packet. They are grown if necessary.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, u64 Packets, u64 Gaussians = 4>
+    void precompute_packet_ray_params(const simd_vec4f_t &o, const std::array<simd_vec4f_t, Packets> &n, const gaussians_t &gaussians,
+            const std::array<ray_params_vec_t*, Packets> &params)
+    {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        const u64 size = gaussians.gaussians.size();
+        for (u64 r = 0; r < Packets; ++r) params[r]->reserve(size);
+        for (u64 i = 0; i < size; i += Gaussians)
+        {
+            /// NOTE: the last block repeats the last gaussian, so that the products do not branch
+            std::array<u64, Gaussians> q;
+            std::array<simd_vec4f_t, Gaussians> origin_to_center;
+            std::array<simd::Vec<simd::Float>, Gaussians> oc_sqnorm;
+            for (u64 b = 0; b < Gaussians; ++b)
+            {
+                q[b] = std::min(i + b, size - 1);
+                const simd_vec4f_t mu{ .x = simd::set1<simd::Float>(g.mu.x[q[b]]), .y = simd::set1<simd::Float>(g.mu.y[q[b]]), .z = simd::set1<simd::Float>(g.mu.z[q[b]]) };
+                origin_to_center[b] = mu - o;
+                oc_sqnorm[b] = origin_to_center[b].sqnorm();
+            }
+            for (u64 r = 0; r < Packets; ++r)
+            {
+                std::array<simd::Vec<simd::Float>, Gaussians> mu_bar;
+                for (u64 b = 0; b < Gaussians; ++b) mu_bar[b] = origin_to_center[b].dot(n[r]);
+                for (u64 b = 0; b < Gaussians && i + b < size; ++b)
+                {
+                    const simd::Vec<simd::Float> weight = simd::set1<simd::Float>(g.weight_scale[q[b]])
+                        * Exp( -((oc_sqnorm[b] - mu_bar[b] * mu_bar[b]) * simd::set1<simd::Float>(g.inv_2_sigma2[q[b]])) );
+                    const f32 inv_sqrt_2_sig = g.inv_sqrt_2_sigma[q[b]];
+                    const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar[b] * simd::set1<simd::Float>(inv_sqrt_2_sig);
+                    ray_params_vec_t &p = *params[r];
+                    simd::store(p.mu_bar + q[b] * SIMD_FLOATS, mu_bar[b]);
+                    simd::store(p.mu_bar_sqrt_2_sigma + q[b] * SIMD_FLOATS, mu_bar_sqrt_2_sig);
+                    simd::store(p.weight + q[b] * SIMD_FLOATS, weight);
+                    simd::store(p.erf1 + q[b] * SIMD_FLOATS, Erf(-mu_bar_sqrt_2_sig));
+                    p.inv_sqrt_2_sigma[q[b]] = inv_sqrt_2_sig;
+                }
+            }
+        }
+    }
+
+    /// A value per packet of rays, gaussian of a block and sample, see `blocked_erf2_sum`.
+    template<u64 Packets, u64 Block, u64 K>
+    using sample_tile_t = std::array<std::array<std::array<simd::Vec<simd::Float>, K>, Block>, Packets>;
+
+    /// Register tile of `precomputed_transmittance`: accumulates the weighted second error functions of all gaussians in
+    /// `params` at the `K` samples of each of `Block` gaussians along the rays of each of `Packets` packets. The
+    /// `Packets` x `Block` x `K` partial optical depths stay in registers. Every gaussian is loaded once per tile instead
+    /// of once per packet and gaussian whose samples are evaluated, and the independent sums hide the latency of the
+    /// error function.
+    /// \param s points along the rays, `K` per packet and gaussian of the block.
+    /// \param params the quantities computed by `precompute_packet_ray_params`, one per packet.
+    /// \param size the number of gaussians in `params`.
+    /// \param erf2_sum the sums of the weighted second error functions per packet and sample.
+    template<simd_f32_func_t Erf = simd::erf, u64 Packets, u64 Block, u64 K>
+    void blocked_erf2_sum(const sample_tile_t<Packets, Block, K> &s, const std::array<const ray_params_vec_t*, Packets> &params, const u64 size,
+            sample_tile_t<Packets, Block, K> &erf2_sum)
+    {
+        for (u64 r = 0; r < Packets; ++r)
+            for (u64 j = 0; j < Block; ++j) erf2_sum[r][j].fill(simd::set1<simd::Float>(0.f));
+        for (u64 i = 0; i < size; ++i)
+        {
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::set1<simd::Float>(params[0]->inv_sqrt_2_sigma[i]);
+            for (u64 r = 0; r < Packets; ++r)
+            {
+                const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = simd::load(params[r]->mu_bar_sqrt_2_sigma + i * SIMD_FLOATS);
+                const simd::Vec<simd::Float> weight = simd::load(params[r]->weight + i * SIMD_FLOATS);
+                for (u64 j = 0; j < Block; ++j)
+                    for (u64 k = 0; k < K; ++k)
+                        erf2_sum[r][j][k] += weight * Erf(s[r][j][k] * inv_sqrt_2_sig - mu_bar_sqrt_2_sig);
+            }
+        }
+    }
+
+    /// Adds the radiance of the `Block` gaussians with the indices `qs` along the rays of each packet to `L_hat`, see
+    /// `packet_blocked_broadcast_radiance`.
+    template<simd_f32_func_t Exp, simd_f32_func_t Erf, typename Quadrature, u64 Packets, u64 Block>
+    void blocked_radiance_tile(const u32 *qs, const gaussians_t &gaussians, const std::array<const ray_params_vec_t*, Packets> &params,
+            const std::array<simd::Vec<simd::Float>, Packets> &erf1_sum, std::array<simd_vec4f_t, Packets> &L_hat)
+    {
+        sample_tile_t<Packets, Block, Quadrature::count> s, erf2_sum;
+        for (u64 r = 0; r < Packets; ++r)
+        {
+            for (u64 j = 0; j < Block; ++j)
+            {
+                const simd::Vec<simd::Float> lambda_q = simd::set1<simd::Float>(gaussians.gaussians[qs[j]].sigma);
+                const simd::Vec<simd::Float> mu_bar = simd::load(params[r]->mu_bar + qs[j] * SIMD_FLOATS);
+                for (u64 k = 0; k < Quadrature::count; ++k) s[r][j][k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda_q;
+            }
+        }
+        blocked_erf2_sum<Erf>(s, params, gaussians.gaussians.size(), erf2_sum);
+        for (u64 r = 0; r < Packets; ++r)
+        {
+            for (u64 j = 0; j < Block; ++j)
+            {
+                simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+                for (u64 k = 0; k < Quadrature::count; ++k)
+                    inner += simd::set1<simd::Float>(Quadrature::weights[k]) * Exp(erf1_sum[r] - erf2_sum[r][j][k]);
+                /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+                inner *= simd::load(params[r]->weight + qs[j] * SIMD_FLOATS) * simd::set1<simd::Float>(SQRT_2_PI);
+                L_hat[r] = L_hat[r] + (simd_vec4f_t::from_vec4f_t(gaussians.gaussians[qs[j]].albedo) * inner);
+            }
+        }
+    }
+
+    /// Computes the radiance along the rays of `Packets` packets whose quantities of the `gaussians` are stored in
+    /// `params`, see `packet_blocked_broadcast_radiance`. The gaussians that are negligible on all rays of all packets are
+    /// dropped before the blocking, see `sample_culling_t`.
+    template<simd_f32_func_t Exp, simd_f32_func_t Erf, typename Quadrature, u64 Packets, u64 Block>
+    std::array<simd_vec4f_t, Packets> blocked_radiance(const gaussians_t &gaussians, const std::array<const ray_params_vec_t*, Packets> &params)
+    {
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local std::vector<u32> visible;
+        const u64 size = gaussians.gaussians.size();
+        /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(size) / SQRT_2_PI;
+        visible.clear();
+        std::array<simd::Vec<simd::Float>, Packets> erf1_sum;
+        erf1_sum.fill(simd::set1<simd::Float>(0.f));
+        for (u64 i = 0; i < size; ++i)
+        {
+            simd::Vec<simd::Float> max_weight = simd::set1<simd::Float>(0.f);
+            for (u64 r = 0; r < Packets; ++r)
+            {
+                const simd::Vec<simd::Float> weight = simd::load(params[r]->weight + i * SIMD_FLOATS);
+                erf1_sum[r] += weight * simd::load(params[r]->erf1 + i * SIMD_FLOATS);
+                max_weight = simd::max(max_weight, weight);
+            }
+            if (simd::hmax(max_weight) * max_albedo(gaussians.gaussians[i].albedo) >= cutoff) visible.push_back(i);
+        }
+        sample_culling.count(size * Packets, (size - visible.size()) * Packets);
+
+        std::array<simd_vec4f_t, Packets> L_hat;
+        L_hat.fill(simd_vec4f_t{ .x = simd::set1<simd::Float>(0.f), .y = simd::set1<simd::Float>(0.f), .z = simd::set1<simd::Float>(0.f), .w = simd::set1<simd::Float>(0.f) });
+        u64 q = 0;
+        for (; q + Block <= visible.size(); q += Block)
+            blocked_radiance_tile<Exp, Erf, Quadrature, Packets, Block>(visible.data() + q, gaussians, params, erf1_sum, L_hat);
+        for (; q < visible.size(); ++q)
+            blocked_radiance_tile<Exp, Erf, Quadrature, Packets, 1>(visible.data() + q, gaussians, params, erf1_sum, L_hat);
+        return L_hat;
+    }
+
+    /// Version of `precomputed_broadcast_radiance` for `Packets` packets of rays with shared origins, such as neighbouring
+    /// packets of a tile. It is a register blocked rays x gaussians kernel: the projections onto the rays are computed as
+    /// small matrix products, see `precompute_packet_ray_params`, and the transmittance is evaluated for the samples of
+    /// `Block` gaussians along the rays of all packets at once, see `blocked_erf2_sum`. The weighted first error functions
+    /// do not depend on the samples and are summed once per packet.
+    /// \param o the origins of the rays, shared by all packets.
+    /// \param n the directions of the rays of each packet. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t, u64 Packets = BLOCKED_PACKETS,
+        u64 Block = BLOCKED_GAUSSIANS>
+    std::array<simd_vec4f_t, Packets> packet_blocked_broadcast_radiance(const simd_vec4f_t &o, const std::array<simd_vec4f_t, Packets> &n,
+            const gaussians_t &gaussians)
+    {
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local std::array<ray_params_vec_t, Packets> params;
+        std::array<ray_params_vec_t*, Packets> out;
+        std::array<const ray_params_vec_t*, Packets> in;
+        for (u64 r = 0; r < Packets; ++r) in[r] = out[r] = &params[r];
+        precompute_packet_ray_params<Exp, Erf>(o, n, gaussians, out);
+        return blocked_radiance<Exp, Erf, Quadrature, Packets, Block>(gaussians, in);
+    }
+
+    /// Version of `packet_blocked_broadcast_radiance` for a single packet of rays.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t, u64 Block = BLOCKED_GAUSSIANS>
+    simd_vec4f_t blocked_broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        return packet_blocked_broadcast_radiance<Exp, Erf, Quadrature, 1, Block>(o, { n }, gaussians)[0];
+    }
+
+    /// Computes the quantities of all `gaussians` that only depend on the rays like `precompute_ray_params`, but for
+    /// anisotropic gaussians. Along a ray o + s * n the exponent of a gaussian with inverse covariance P is
+    /// -(a * s^2 - 2 * b * s + c) / 2 with a = n^T P n, b = n^T P (mu - o) and c = (mu - o)^T P (mu - o), i.e. a 1D
+    /// gaussian with center `mu_bar` = b / a, standard deviation 1 / sqrt(a) and peak magnitude * exp(-(c - b^2 / a) / 2).
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
+    void precompute_anisotropic_ray_params(const simd_vec4f_t &o, const simd_vec4f_t &n, const gaussians_t &gaussians, ray_params_vec_t &params)
+    {
+        const gaussian_vec_t &g = *gaussians.soa_gaussians;
+        const u64 size = gaussians.gaussians.size();
+        params.reserve(size);
+        for (u64 i = 0; i < size; ++i)
+        {
+            const simd::Vec<simd::Float> xx = simd::set1<simd::Float>(g.precision.xx[i]), xy = simd::set1<simd::Float>(g.precision.xy[i]),
+                  xz = simd::set1<simd::Float>(g.precision.xz[i]), yy = simd::set1<simd::Float>(g.precision.yy[i]),
+                  yz = simd::set1<simd::Float>(g.precision.yz[i]), zz = simd::set1<simd::Float>(g.precision.zz[i]);
+            const simd::Vec<simd::Float> dx = simd::set1<simd::Float>(g.mu.x[i]) - o.x;
+            const simd::Vec<simd::Float> dy = simd::set1<simd::Float>(g.mu.y[i]) - o.y;
+            const simd::Vec<simd::Float> dz = simd::set1<simd::Float>(g.mu.z[i]) - o.z;
+            const simd::Vec<simd::Float> Pn_x = xx * n.x + xy * n.y + xz * n.z;
+            const simd::Vec<simd::Float> Pn_y = xy * n.x + yy * n.y + yz * n.z;
+            const simd::Vec<simd::Float> Pn_z = xz * n.x + yz * n.y + zz * n.z;
+            const simd::Vec<simd::Float> a = n.x * Pn_x + n.y * Pn_y + n.z * Pn_z;
+            const simd::Vec<simd::Float> b = dx * Pn_x + dy * Pn_y + dz * Pn_z;
+            const simd::Vec<simd::Float> c = dx * (xx * dx + xy * dy + xz * dz) + dy * (xy * dx + yy * dy + yz * dz) + dz * (xz * dx + yz * dy + zz * dz);
+
+            const simd::Vec<simd::Float> mu_bar = b / a;
+            const simd::Vec<simd::Float> sigma_bar = simd::sqrt(simd::set1<simd::Float>(1.f) / a);
+            const simd::Vec<simd::Float> c_bar = simd::set1<simd::Float>(g.magnitude[i]) * Exp(simd::set1<simd::Float>(-.5f) * (c - b * mu_bar));
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::sqrt(a * simd::set1<simd::Float>(.5f));
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * inv_sqrt_2_sig;
+            simd::store(params.mu_bar + i * SIMD_FLOATS, mu_bar);
+            simd::store(params.mu_bar_sqrt_2_sigma + i * SIMD_FLOATS, mu_bar_sqrt_2_sig);
+            simd::store(params.weight + i * SIMD_FLOATS, sigma_bar * c_bar * simd::set1<simd::Float>(INV_SQRT_2_PI));
+            simd::store(params.erf1 + i * SIMD_FLOATS, Erf(-mu_bar_sqrt_2_sig));
+            simd::store(params.inv_sqrt_2_sigma_bar + i * SIMD_FLOATS, inv_sqrt_2_sig);
+        }
+    }
+
+    /// Version of `precomputed_transmittance` for the quantities computed by `precompute_anisotropic_ray_params`.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, u64 K>
+    std::array<simd::Vec<simd::Float>, K> anisotropic_transmittance(const std::array<simd::Vec<simd::Float>, K> &s, const ray_params_vec_t &params, const u64 size)
+    {
+        std::array<simd::Vec<simd::Float>, K> T;
+        T.fill(simd::set1<simd::Float>(0.f));
+        for (u64 i = 0; i < size; ++i)
+        {
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::load(params.inv_sqrt_2_sigma_bar + i * SIMD_FLOATS);
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = simd::load(params.mu_bar_sqrt_2_sigma + i * SIMD_FLOATS);
+            const simd::Vec<simd::Float> weight = simd::load(params.weight + i * SIMD_FLOATS);
+            const simd::Vec<simd::Float> erf1 = simd::load(params.erf1 + i * SIMD_FLOATS);
+            for (u64 k = 0; k < K; ++k)
+            {
+                const simd::Vec<simd::Float> erf2 = Erf(s[k] * inv_sqrt_2_sig - mu_bar_sqrt_2_sig);
+                T[k] += weight * (erf1 - erf2);
+            }
+        }
+        for (u64 k = 0; k < K; ++k) T[k] = Exp(T[k]);
+        return T;
+    }
+
+    /// Version of `precomputed_broadcast_radiance` for anisotropic gaussians, see `gaussian_t::scale` and
+    /// `gaussian_t::rotation`. The samples of a gaussian are spaced by its standard deviation along each ray.
+    /// For isotropic gaussians it computes the same image as `precomputed_broadcast_radiance`.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t>
+    simd_vec4f_t anisotropic_broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local ray_params_vec_t params;
+        const u64 size = gaussians.gaussians.size();
+        precompute_anisotropic_ray_params<Exp, Erf>(o, n, gaussians, params);
+        /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(size) / SQRT_2_PI;
+        u64 skipped = 0;
+
+        simd_vec4f_t L_hat{ .x = simd::set1<simd::Float>(0.f), .y = simd::set1<simd::Float>(0.f), .z = simd::set1<simd::Float>(0.f), .w = simd::set1<simd::Float>(0.f) };
+        for (u64 i = 0; i < size; ++i)
+        {
+            const vec4f_t &albedo = gaussians.gaussians[i].albedo;
+            if (simd::hmax(simd::load(params.weight + i * SIMD_FLOATS)) * max_albedo(albedo) < cutoff)
+            {
+                ++skipped;
+                continue;
+            }
+            const simd::Vec<simd::Float> lambda_q = simd::set1<simd::Float>(1.f / SQRT_2) / simd::load(params.inv_sqrt_2_sigma_bar + i * SIMD_FLOATS);
+            const simd::Vec<simd::Float> mu_bar = simd::load(params.mu_bar + i * SIMD_FLOATS);
+            std::array<simd::Vec<simd::Float>, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda_q;
+            const std::array<simd::Vec<simd::Float>, Quadrature::count> T = anisotropic_transmittance<Exp, Erf>(s, params, size);
+            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * T[k];
+            /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+            inner *= simd::load(params.weight + i * SIMD_FLOATS) * simd::set1<simd::Float>(SQRT_2_PI);
+            L_hat = L_hat + (simd_vec4f_t::from_vec4f_t(albedo) * inner);
+        }
+        sample_culling.count(size, skipped);
+        return L_hat;
+    }
+
+    /// Version of `precomputed_broadcast_radiance` that only takes the gaussians into account which intersect at least one
+    /// of the rays, see `cull_gaussians` and `cone_cull_gaussians`. The culled gaussians neither occlude nor emit along the rays.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, cull_func_t Cull = cull_gaussians, typename Quadrature = riemann_quadrature_t>
+    simd_vec4f_t culled_broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local ray_params_vec_t params;
+        static thread_local std::vector<u32> indices;
+        indices.resize(gaussians.soa_gaussians->size);
+        const u64 count = Cull(o, n, gaussians, indices.data());
+        precompute_ray_params<Exp, Erf>(o, n, gaussians, params, indices.data(), count);
+        /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+        const f32 cutoff = sample_culling.cutoff<Quadrature>(count) / SQRT_2_PI;
+        u64 skipped = 0;
+
+        simd_vec4f_t L_hat{ .x = simd::set1<simd::Float>(0.f), .y = simd::set1<simd::Float>(0.f), .z = simd::set1<simd::Float>(0.f), .w = simd::set1<simd::Float>(0.f) };
+        for (u64 i = 0; i < count; ++i)
+        {
+            const gaussian_t &G_q = gaussians.gaussians[indices[i]];
+            if (simd::hmax(simd::load(params.weight + i * SIMD_FLOATS)) * max_albedo(G_q.albedo) < cutoff)
+            {
+                ++skipped;
+                continue;
+            }
+            const simd::Vec<simd::Float> lambda_q = simd::set1<simd::Float>(G_q.sigma);
+            const simd::Vec<simd::Float> mu_bar = simd::load(params.mu_bar + i * SIMD_FLOATS);
+            std::array<simd::Vec<simd::Float>, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda_q;
+            const std::array<simd::Vec<simd::Float>, Quadrature::count> T = precomputed_transmittance<Exp, Erf>(s, params, count);
+            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * T[k];
+            /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+            inner *= simd::load(params.weight + i * SIMD_FLOATS) * simd::set1<simd::Float>(SQRT_2_PI);
+            L_hat = L_hat + (simd_vec4f_t::from_vec4f_t(G_q.albedo) * inner);
+        }
+        sample_culling.count(count, skipped);
+        return L_hat;
+    }
+
+    /// Version of `precomputed_broadcast_radiance` whose cost per sample does not depend on the number of gaussians.
+    /// The optical depth at a sample is estimated from `Subset` gaussians drawn with a probability proportional to the
+    /// bound `weight * (1 - erf1)` of their optical depth along any of the rays, reweighted by the inverse probability.
+    /// Since the exponential of an unbiased estimate is biased, the transmittance is estimated as
+    /// exp(-tau_0) * prod_{i=1..K} (1 - (tau_i - tau_0) / lambda) with independent estimates tau_i of the optical depth
+    /// and K drawn from a Poisson distribution with mean `stochastic_transmittance.lambda`, which is unbiased.
+    /// Every ray draws its own gaussians with a generator seeded by its pixel, see `stochastic_transmittance_t::packet`,
+    /// and `stochastic_transmittance.frame`, so the noise of neighbouring pixels is independent and frames are
+    /// reproducible.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, u64 Subset = 32, typename Quadrature = riemann_quadrature_t>
+    simd_vec4f_t stochastic_broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local ray_params_vec_t params;
+        static thread_local std::vector<f32> cdf;
+        const u64 size = gaussians.gaussians.size();
+        const simd::Vec<simd::Float> zero = simd::set1<simd::Float>(0.f);
+        simd_vec4f_t L_hat{ .x = zero, .y = zero, .z = zero, .w = zero };
+        if (size == 0) return L_hat;
+        precompute_ray_params<Exp, Erf>(o, n, gaussians, params);
+
+        /// the optical depth of a gaussian along a ray is weight * (erf2 - erf1) <= weight * (1 - erf1)
+        cdf.resize(size);
+        f32 total = 0.f;
+        u64 last = 0;
+        for (u64 i = 0; i < size; ++i)
+        {
+            const f32 bound = simd::hmax(simd::load(params.weight + i * SIMD_FLOATS) * (simd::set1<simd::Float>(1.f) - simd::load(params.erf1 + i * SIMD_FLOATS)));
+            if (bound > 0.f) last = i;
+            total += std::max(bound, 0.f);
+            cdf[i] = total;
+        }
+
+        std::array<rng_t, SIMD_FLOATS> rng;
+        for (u64 r = 0; r < SIMD_FLOATS; ++r)
+        {
+            rng[r].state = (u64)stochastic_transmittance.packet.pixel(r) << 32 | stochastic_transmittance.frame;
+            rng[r].next();
+        }
+        const f32 lambda = stochastic_transmittance.lambda;
+        alignas(NATIVE_SIMD_WIDTH) f32 active[SIMD_FLOATS], inv_sqrt_2_sigs[SIMD_FLOATS], mu_bar_sqrt_2_sigs[SIMD_FLOATS], ws[SIMD_FLOATS], erf1s[SIMD_FLOATS];
+        u64 corrections[SIMD_FLOATS];
+
+        for (u64 q = 0; q < size; ++q)
+        {
+            const simd::Vec<simd::Float> weight = simd::load(params.weight + q * SIMD_FLOATS);
+            if (simd::hmax(weight) <= MIN_WEIGHT) continue;
+            const vec4f_t &albedo = gaussians.gaussians[q].albedo;
+            const simd::Vec<simd::Float> lambda_q = simd::set1<simd::Float>(gaussians.gaussians[q].sigma);
+            const simd::Vec<simd::Float> mu_bar = simd::load(params.mu_bar + q * SIMD_FLOATS);
+            std::array<simd::Vec<simd::Float>, Quadrature::count> s, T;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda_q;
+
+            std::array<simd::Vec<simd::Float>, Quadrature::count> tau_0;
+            u64 max_corrections = 0;
+            for (u64 r = 0; r < SIMD_FLOATS; ++r)
+            {
+                corrections[r] = rng[r].poisson(lambda);
+                max_corrections = std::max(max_corrections, corrections[r]);
+            }
+            for (u64 e = 0; e <= max_corrections; ++e)
+            {
+                std::array<simd::Vec<simd::Float>, Quadrature::count> tau;
+                tau.fill(zero);
+                for (u64 m = 0; m < Subset; ++m)
+                {
+                    /// every ray draws its own gaussian, so their parameters are gathered per lane
+                    for (u64 r = 0; r < SIMD_FLOATS; ++r)
+                    {
+                        const u64 j = std::min<u64>(std::upper_bound(cdf.begin(), cdf.end(), rng[r].uniform() * total) - cdf.begin(), last);
+                        /// NOTE: the inverse probability of drawing `j` is total / bound_j
+                        const f32 inv_p = total / (cdf[j] - (j > 0 ? cdf[j - 1] : 0.f)) / Subset;
+                        inv_sqrt_2_sigs[r] = params.inv_sqrt_2_sigma[j];
+                        mu_bar_sqrt_2_sigs[r] = params.mu_bar_sqrt_2_sigma[j * SIMD_FLOATS + r];
+                        ws[r] = params.weight[j * SIMD_FLOATS + r] * inv_p;
+                        erf1s[r] = params.erf1[j * SIMD_FLOATS + r];
+                    }
+                    const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::load(inv_sqrt_2_sigs);
+                    const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = simd::load(mu_bar_sqrt_2_sigs);
+                    const simd::Vec<simd::Float> w = simd::load(ws);
+                    const simd::Vec<simd::Float> erf1 = simd::load(erf1s);
+                    for (u64 k = 0; k < Quadrature::count; ++k)
+                        tau[k] += w * (Erf(s[k] * inv_sqrt_2_sig - mu_bar_sqrt_2_sig) - erf1);
+                }
+                /// the rays with fewer corrections keep their transmittance
+                for (u64 r = 0; r < SIMD_FLOATS; ++r) active[r] = (e <= corrections[r]) ? 1.f / lambda : 0.f;
+                for (u64 k = 0; k < Quadrature::count; ++k)
+                {
+                    if (e == 0)
+                    {
+                        tau_0[k] = tau[k];
+                        T[k] = Exp(-tau[k]);
+                    }
+                    else T[k] *= simd::set1<simd::Float>(1.f) - (tau[k] - tau_0[k]) * simd::load(active);
+                }
+            }
+
+            simd::Vec<simd::Float> inner = zero;
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * T[k];
+            /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+            inner *= weight * simd::set1<simd::Float>(SQRT_2_PI);
+            L_hat = L_hat + (simd_vec4f_t::from_vec4f_t(albedo) * inner);
+        }
+        return L_hat;
+    }
+
+    /// Version of `precomputed_broadcast_radiance` that accumulates the radiance front to back. The gaussians are
+    /// ordered by their first sample averaged over the set of rays. A ray is retired once the transmittance at the first
+    /// sample of the current gaussian falls below `Epsilon` and no remaining gaussian starts before that sample along the
+    /// ray, or once all of its color channels are saturated. The remaining gaussians can then not change its final color
+    /// noticeably. The evaluation stops once all rays are retired.
+    /// \param o the origins of the rays.
+    /// \param n the directions of the rays. These should be unit vectors.
+    /// \param gaussians the gaussians to take into account for the computation.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, f32 Epsilon = TERMINATION_EPSILON, typename Quadrature = riemann_quadrature_t>
+    simd_vec4f_t front_to_back_broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    {
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local ray_params_vec_t params;
+        static thread_local std::vector<u32> order;
+        static thread_local std::vector<f32> depth;
+        static thread_local std::vector<f32> first_remaining;
+        const u64 size = gaussians.gaussians.size();
+        precompute_ray_params<Exp, Erf>(o, n, gaussians, params);
+
+        order.resize(size);
+        depth.resize(size);
+        for (u64 i = 0; i < size; ++i)
+        {
+            order[i] = i;
+            depth[i] = simd::hadds(simd::load(params.mu_bar + i * SIMD_FLOATS)) / SIMD_FLOATS + Quadrature::offsets[0] * gaussians.gaussians[i].sigma;
+        }
+        std::sort(order.begin(), order.end(), [](const u32 a, const u32 b) { return depth[a] < depth[b]; });
+
+        const simd::Vec<simd::Float> zero = simd::set1<simd::Float>(0.f);
+        const simd::Vec<simd::Float> one = simd::set1<simd::Float>(1.f);
+        const simd::Vec<simd::Float> epsilon = simd::set1<simd::Float>(Epsilon);
+
+        /// the order only holds on average, so the first sample of the gaussians from the `q`-th on is tracked per ray.
+        /// Gaussians that do not intersect a ray are ignored for it.
+        first_remaining.resize((size + 1) * SIMD_FLOATS);
+        simd::Vec<simd::Float> first = simd::set1<simd::Float>(std::numeric_limits<f32>::max());
+        simd::storeu(first_remaining.data() + size * SIMD_FLOATS, first);
+        for (u64 q = size; q-- > 0;)
+        {
+            const u32 i = order[q];
+            const simd::Vec<simd::Float> s0 = simd::load(params.mu_bar + i * SIMD_FLOATS)
+                + simd::set1<simd::Float>(Quadrature::offsets[0] * gaussians.gaussians[i].sigma);
+            const simd::Vec<simd::Float> intersects = simd::cmpgt(simd::load(params.weight + i * SIMD_FLOATS), simd::set1<simd::Float>(MIN_WEIGHT));
+            first = simd::min(first, simd::ifelse(intersects, s0, first));
+            simd::storeu(first_remaining.data() + q * SIMD_FLOATS, first);
+        }
+
+        simd::Vec<simd::Float> active = simd::cmpeq(zero, zero);
+        simd_vec4f_t L_hat{ .x = zero, .y = zero, .z = zero, .w = zero };
+        for (u64 q = 0; q < size; ++q)
+        {
+            const u32 i = order[q];
+            const vec4f_t &albedo = gaussians.gaussians[i].albedo;
+            const simd::Vec<simd::Float> lambda_q = simd::set1<simd::Float>(gaussians.gaussians[i].sigma);
+            const simd::Vec<simd::Float> mu_bar = simd::load(params.mu_bar + i * SIMD_FLOATS);
+            std::array<simd::Vec<simd::Float>, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = mu_bar + simd::set1<simd::Float>(Quadrature::offsets[k]) * lambda_q;
+            const std::array<simd::Vec<simd::Float>, Quadrature::count> T = precomputed_transmittance<Exp, Erf>(s, params, size);
+            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += simd::set1<simd::Float>(Quadrature::weights[k]) * T[k];
+            /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+            inner *= simd::load(params.weight + i * SIMD_FLOATS) * simd::set1<simd::Float>(SQRT_2_PI);
+            L_hat = L_hat + (simd_vec4f_t::from_vec4f_t(albedo) * simd::ifelse(active, inner, zero));
+
+            /// NOTE: the transmittance only decreases along the ray, so it bounds all samples of the remaining gaussians
+            const simd::Vec<simd::Float> opaque = simd::bit_and(simd::cmplt(T[0], epsilon),
+                    simd::cmple(s[0], simd::loadu(first_remaining.data() + (q + 1) * SIMD_FLOATS)));
+            const simd::Vec<simd::Float> saturated = simd::cmpge(simd::min(simd::min(L_hat.x, L_hat.y), L_hat.z), one);
+            active = simd::bit_andnot(simd::bit_or(opaque, saturated), active);
+            if (simd::test_all_zeros(active)) break;
+        }
+        return L_hat;
+    }
+
+    /// Computes the quantities of `gaussians` along a single ray, sorts them by their projected centers `mu_bar` and
+    /// stores them in `params`. Gaussians whose weight is negligible for the ray are dropped, they neither occlude nor
+    /// emit along it.
+    /// \param o the origin of the ray.
+    /// \param n the direction of the ray. This should be a unit vector.
+    /// \param gaussians the gaussians to take into account for the computation.
+    /// \param params the scratch buffer to write into. It is grown if necessary.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
+    void sort_ray_params(const vec4f_t _o, const vec4f_t _n, const gaussians_t &gaussians, sorted_params_vec_t &params)
     {
-        simd::Vec<simd::Float> T = simd::set1<simd::Float>(0.f);
-        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        const u64 size = gaussians.gaussians.size();
+        params.reserve(size);
+
+        const simd_vec4f_t o = simd_vec4f_t::from_vec4f_t(_o);
+        const simd_vec4f_t n = simd_vec4f_t::from_vec4f_t(_n);
+        simd::Vec<simd::Float> erf1_sum = simd::set1<simd::Float>(0.f);
+        for (u64 i = 0; i < size; i += SIMD_FLOATS)
         {
-            const simd_gaussian_t G_q = simd_gaussian_t::from_gaussian_t(gaussians.gaussians[i]);
-            const simd_vec4f_t origin_to_center = G_q.mu - o;
+            const simd::Vec<simd::Float> mask = tail_mask(size - i);
+            const simd_vec4f_t mu{ .x = masked_load(gaussians.soa_gaussians->mu.x + i, mask),
+                .y = masked_load(gaussians.soa_gaussians->mu.y + i, mask),
+                .z = masked_load(gaussians.soa_gaussians->mu.z + i, mask) };
+
+            const simd_vec4f_t origin_to_center = mu - o;
             const simd::Vec<simd::Float> mu_bar = (origin_to_center).dot(n);
-            const simd::Vec<simd::Float> mb2 = mu_bar * mu_bar;
-            const simd::Vec<simd::Float> oc_sqnorm = origin_to_center.sqnorm();
-            const simd::Vec<simd::Float> sigma2 = G_q.sigma * G_q.sigma;
-            const simd::Vec<simd::Float> inv_2_sigma2 = simd::rcp(simd::set1<simd::Float>(2.f) * sigma2);
-            const simd::Vec<simd::Float> oc_sqnorm_diff_mb2 = oc_sqnorm - mb2;
-            const simd::Vec<simd::Float> c_bar = G_q.magnitude * Exp( -(oc_sqnorm_diff_mb2 * inv_2_sigma2) );
+            const simd::Vec<simd::Float> weight = masked_load(gaussians.soa_gaussians->weight_scale + i, mask)
+                * Exp(-((origin_to_center.sqnorm() - mu_bar * mu_bar) * masked_load(gaussians.soa_gaussians->inv_2_sigma2 + i, mask)));
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = masked_load(gaussians.soa_gaussians->inv_sqrt_2_sigma + i, mask);
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * inv_sqrt_2_sig;
+            /// NOTE: the dropped gaussians are masked, they would add their first error functions without the second ones
+            erf1_sum += simd::bit_and(simd::cmpgt(weight, simd::set1<simd::Float>(MIN_WEIGHT)), weight * Erf(-mu_bar_sqrt_2_sig));
 
-            const simd::Vec<simd::Float> sqrt_2_sig = simd::set1<simd::Float>(SQRT_2) * G_q.sigma;
+            simd::store(params.unsorted.mu_bar + i, mu_bar);
+            simd::store(params.unsorted.mu_bar_sqrt_2_sigma + i, mu_bar_sqrt_2_sig);
+            simd::store(params.unsorted.weight + i, weight);
+            simd::store(params.unsorted.inv_sqrt_2_sigma + i, inv_sqrt_2_sig);
+        }
+        /// NOTE: the lanes past the last gaussian are masked and therefore do not contribute to `erf1_sum`
+        params.erf1_sum = simd::hadds(erf1_sum);
 
-            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = mu_bar * simd::rcp(sqrt_2_sig);;
-            const simd::Vec<simd::Float> s_sqrt_2_sig = s * simd::rcp(sqrt_2_sig);
-            const simd::Vec<simd::Float> erf1 = Erf(-mu_bar_sqrt_2_sig);
-            const simd::Vec<simd::Float> erf2 = Erf(s_sqrt_2_sig - mu_bar_sqrt_2_sig);
-            T += G_q.sigma * c_bar * simd::set1<simd::Float>(INV_SQRT_2_PI) * (erf1 - erf2);
+        u64 count = 0;
+        for (u64 i = 0; i < size; ++i)
+            if (params.unsorted.weight[i] > MIN_WEIGHT) params.order[count++] = i;
+        std::sort(params.order.begin(), params.order.begin() + count,
+                [mu_bar = params.unsorted.mu_bar](const u32 a, const u32 b) { return mu_bar[a] < mu_bar[b]; });
+        params.prefix_weight[0] = 0.f;
+        for (u64 i = 0; i < count; ++i)
+        {
+            const u32 j = params.order[i];
+            params.sorted.mu_bar[i] = params.unsorted.mu_bar[j];
+            params.sorted.mu_bar_sqrt_2_sigma[i] = params.unsorted.mu_bar_sqrt_2_sigma[j];
+            params.sorted.weight[i] = params.unsorted.weight[j];
+            params.sorted.inv_sqrt_2_sigma[i] = params.unsorted.inv_sqrt_2_sigma[j];
+            params.prefix_weight[i + 1] = params.prefix_weight[i] + params.sorted.weight[i];
+            const f32 support = SUPPORT_RADIUS * gaussians.soa_gaussians->sigma[j];
+            params.support_end[i] = std::max((i > 0) ? params.support_end[i - 1] : -std::numeric_limits<f32>::max(), params.sorted.mu_bar[i] + support);
+            params.support_begin[i] = params.sorted.mu_bar[i] - support;
         }
-        return Exp(T);
+        for (u64 i = count; i-- > 1;) params.support_begin[i - 1] = std::min(params.support_begin[i - 1], params.support_begin[i]);
+        for (u64 i = count; i < count + SIMD_FLOATS; ++i)
+        {
+            params.sorted.mu_bar_sqrt_2_sigma[i] = 0.f;
+            params.sorted.weight[i] = 0.f;
+            params.sorted.inv_sqrt_2_sigma[i] = 0.f;
+        }
+        params.count = count;
     }
 
-    /// Numerical approximation of the transmittance.
-    f32 transmittance_step(const vec4f_t o, const vec4f_t n, const f32 s, const f32 delta, const std::vector<gaussian_t> gaussians);
-
-    /// Returns the combined density at point `pt` for the given set of gaussians.
-    f32 density(const vec4f_t pt, const std::vector<gaussian_t> gaussians);
+    /// Calculates the transmittance at the points `s` along a ray from the quantities sorted by `sort_ray_params`.
+    /// The second error function of every gaussian whose support `mu_bar +- SUPPORT_RADIUS * sigma` lies entirely before
+    /// all of the samples is saturated to 1 and that of every gaussian whose support lies entirely after all of them is
+    /// saturated to -1. Their contributions are taken from the prefix sums over the sorted weights, so only the gaussians
+    /// overlapping the samples are evaluated exactly.
+    /// \param s points along the ray.
+    /// \param params the quantities computed by `sort_ray_params`.
+    /// \return the exponents of the transmittance at the points `s`.
+    template<simd_f32_func_t Erf = simd::erf, u64 K>
+    std::array<f32, K> sorted_transmittance_exponent(const std::array<f32, K> &s, const sorted_params_vec_t &params)
+    {
+        const auto [s_min, s_max] = std::minmax_element(s.begin(), s.end());
+        /// gaussians before `lo` end before every sample, gaussians from `hi` on start after every sample
+        const u64 lo = std::lower_bound(params.support_end, params.support_end + params.count, *s_min) - params.support_end;
+        const u64 hi = std::max<u64>(lo, std::upper_bound(params.support_begin, params.support_begin + params.count, *s_max) - params.support_begin);
+        const f32 saturated = params.erf1_sum - params.prefix_weight[lo] + (params.prefix_weight[params.count] - params.prefix_weight[hi]);
 
-    /// Separate the given gaussians into sets based on which tiles of the image they affect.
-    /// \param tw width of the image tiles.
-    /// \param th height of the image tiles.
-    /// \param gaussians the set of gaussians to separate.
-    /// \param view the view matrix of the scene.
-    tiles_t tile_gaussians(const f32 tw, const f32 th, const std::vector<gaussian_t> &gaussians, const glm::mat4 &view);
+        std::array<simd::Vec<simd::Float>, K> erf2_sum;
+        erf2_sum.fill(simd::set1<simd::Float>(0.f));
+        for (u64 j = lo; j < hi; j += SIMD_FLOATS)
+        {
+            const simd::Vec<simd::Float> weight = simd::bit_and(tail_mask(hi - j), simd::loadu(params.sorted.weight + j));
+            const simd::Vec<simd::Float> inv_sqrt_2_sig = simd::loadu(params.sorted.inv_sqrt_2_sigma + j);
+            const simd::Vec<simd::Float> mu_bar_sqrt_2_sig = simd::loadu(params.sorted.mu_bar_sqrt_2_sigma + j);
+            for (u64 k = 0; k < K; ++k)
+                erf2_sum[k] += weight * Erf(simd::set1<simd::Float>(s[k]) * inv_sqrt_2_sig - mu_bar_sqrt_2_sig);
+        }
+        std::array<f32, K> T;
+        for (u64 k = 0; k < K; ++k) T[k] = saturated - simd::hadds(erf2_sum[k]);
+        return T;
+    }
 
-    /// Approximates the radiance integral L along the given ray o + s*n.
+    /// Version of `radiance` that sorts the gaussians along the ray by their projected centers `mu_bar`, see
+    /// `sort_ray_params` and `sorted_transmittance_exponent`. This reduces the cost per ray from O(N^2) to O(N log N)
+    /// plus the size of the windows of gaussians overlapping the samples.
     /// \param o the origin of the ray.
     /// \param n the direction of the ray. This should be a unit vector.
     /// \param gaussians the gaussians to take into account for the computation.
-    template<transmittance_func_t Tr = simd_transmittance>
-    vec4f_t radiance(const vec4f_t o, const vec4f_t n, const gaussians_t &gaussians)
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, f32_func_t Expf = expf, typename Quadrature = riemann_quadrature_t>
+    vec4f_t sorted_radiance(const vec4f_t o, const vec4f_t n, const gaussians_t &gaussians)
     {
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local sorted_params_vec_t params;
+        if (gaussians.gaussians.size() == 0) return vec4f_t{ .x = 0.f, .y = 0.f, .z = 0.f };
+        sort_ray_params<Exp, Erf>(o, n, gaussians, params);
+
         vec4f_t L_hat{ .x = 0.f, .y = 0.f, .z = 0.f };
-        for (u64 i = 0; i < gaussians.gaussians.size(); ++i)
+        for (u64 q = 0; q < params.count; ++q)
         {
-            const gaussian_t &G_q = gaussians.gaussians[i];
-            const f32 lambda_q = G_q.sigma;
+            const gaussian_t &G_q = gaussians.gaussians[params.order[q]];
+            std::array<f32, Quadrature::count> s;
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = params.sorted.mu_bar[q] + Quadrature::offsets[k] * G_q.sigma;
+            const std::array<f32, Quadrature::count> T = sorted_transmittance_exponent<Erf>(s, params);
             f32 inner = 0.f;
-            for (i8 k = -4; k <= 0; ++k)
-            {
-                const f32 s = (G_q.mu - o).dot(n) + k * lambda_q;
-                const f32 T = Tr(o, n, s, gaussians);
-                inner += G_q.pdf(o + (n * s)) * T * lambda_q;
-            }
-            L_hat = L_hat + (G_q.albedo * inner);
+            for (u64 k = 0; k < Quadrature::count; ++k)
+                inner += Quadrature::weights[k] * Expf(T[k]);
+            /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+            L_hat = L_hat + (G_q.albedo * (params.sorted.weight[q] * SQRT_2_PI * inner));
         }
         return L_hat;
     }
 
-    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
-    vec4f_t simd_radiance(const vec4f_t _o, const vec4f_t _n, const gaussians_t &gaussians)
-    {
-        simd_vec4f_t L_hat{};
-        for (u64 i = 0; i < gaussians.gaussians.size(); i += SIMD_FLOATS)
-        {
-            simd_gaussian_t g_q{
-                .albedo{
-                    .x = simd::load(gaussians.soa_gaussians->albedo.r + i),
-                    .y = simd::load(gaussians.soa_gaussians->albedo.g + i),
-                    .z = simd::load(gaussians.soa_gaussians->albedo.b + i),
-                    .w = simd::set1<simd::Float>(1.f)
-                },
-                .mu{
-                    .x = simd::load(gaussians.soa_gaussians->mu.x + i),
-                    .y = simd::load(gaussians.soa_gaussians->mu.y + i),
-                    .z = simd::load(gaussians.soa_gaussians->mu.z + i) },
-                .sigma = simd::load(gaussians.soa_gaussians->sigma + i),
-                .magnitude = simd::load(gaussians.soa_gaussians->magnitude + i)
-            };
-            simd_vec4f_t o = simd_vec4f_t::from_vec4f_t(_o);
-            simd_vec4f_t n = simd_vec4f_t::from_vec4f_t(_n);
-            const simd::Vec<simd::Float> lambda = g_q.sigma;
-            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
-            for (i8 k = -4; k <= 0; ++k)
-            {
-                const simd::Vec<simd::Float> s = (g_q.mu - o).dot(n) + simd::set1<simd::Float>(k) * lambda;
-                const simd::Vec<simd::Float> T = broadcast_transmittance<Exp, Erf>(o, n, s, gaussians);
-                inner += g_q.pdf(o + (n * s)) * T * lambda;
-            }
-            L_hat = L_hat + (g_q.albedo * inner);
-        }
-        return L_hat.hadds();
-    }
-
-    /// Version of `radiance` that operates a set of `SIMD_FLOATS` rays.
-    /// \param o the origins of the rays.
-    /// \param n the directions of the rays. These should be unit vectors.
+    /// Version of `sorted_radiance` that chooses the number of samples per gaussian adaptively. The transmittance
+    /// only decreases along the ray, so every sample that has not been evaluated yet is bounded by the transmittance
+    /// at the closest evaluated samples before and after it. The sample with the largest weight is evaluated first, further
+    /// samples are evaluated in order of their possible error until the error bound of the contribution of the gaussian
+    /// falls below `adaptive_quadrature.tolerance`. The samples that have not been evaluated are estimated by the
+    /// midpoint of their bounds. Faint and occluded gaussians therefore need only one or two samples.
+    /// \param o the origin of the ray.
+    /// \param n the direction of the ray. This should be a unit vector.
     /// \param gaussians the gaussians to take into account for the computation.
-    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
-    simd_vec4f_t broadcast_radiance(const simd_vec4f_t o, const simd_vec4f_t n, const gaussians_t &gaussians)
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, f32_func_t Expf = expf, typename Quadrature = riemann_quadrature_t>
+    vec4f_t adaptive_radiance(const vec4f_t o, const vec4f_t n, const gaussians_t &gaussians)
     {
-        simd_vec4f_t L_hat{ .x = simd::set1<simd::Float>(0.f), .y = simd::set1<simd::Float>(0.f), .z = simd::set1<simd::Float>(0.f), .w = simd::set1<simd::Float>(0.f) };
-        for (const gaussian_t &_G_q : gaussians.gaussians)
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local sorted_params_vec_t params;
+        if (gaussians.gaussians.size() == 0) return vec4f_t{ .x = 0.f, .y = 0.f, .z = 0.f };
+        sort_ray_params<Exp, Erf>(o, n, gaussians, params);
+
+        u64 samples = 0;
+        vec4f_t L_hat{ .x = 0.f, .y = 0.f, .z = 0.f };
+        for (u64 q = 0; q < params.count; ++q)
         {
-            const simd_gaussian_t G_q = simd_gaussian_t::from_gaussian_t(_G_q);
-            const simd::Vec<simd::Float> lambda_q = G_q.sigma;
-            simd::Vec<simd::Float> inner = simd::set1<simd::Float>(0.f);
-            for (i8 k = -4; k <= 0; ++k)
+            const gaussian_t &G_q = gaussians.gaussians[params.order[q]];
+            /// NOTE: c_bar * sigma = weight * sqrt(2/pi)
+            const f32 scale = params.sorted.weight[q] * SQRT_2_PI;
+            const f32 tolerance = adaptive_quadrature.tolerance / (scale * std::max({ G_q.albedo.x, G_q.albedo.y, G_q.albedo.z, 1e-6f }));
+
+            std::array<f32, Quadrature::count> s, T;
+            std::array<bool, Quadrature::count> evaluated{};
+            for (u64 k = 0; k < Quadrature::count; ++k) s[k] = params.sorted.mu_bar[q] + Quadrature::offsets[k] * G_q.sigma;
+            /// the samples are ordered along the ray, the one with the largest weight is evaluated first
+            u64 next = std::max_element(Quadrature::weights.begin(), Quadrature::weights.end()) - Quadrature::weights.begin();
+            f32 inner = 0.f;
+            while (true)
             {
-                const simd::Vec<simd::Float> s = (G_q.mu - o).dot(n) + simd::set1<simd::Float>(k) * lambda_q;
-                simd::Vec<simd::Float> T = broadcast_transmittance<Exp, Erf>(o, n, s, gaussians);
-                inner += G_q.pdf(o + (n * s)) * T * lambda_q;
+                T[next] = Expf(sorted_transmittance_exponent<Erf>(std::array<f32, 1>{ s[next] }, params)[0]);
+                evaluated[next] = true;
+                ++samples;
+
+                inner = 0.f;
+                f32 error = 0.f, max_error = 0.f;
+                f32 upper = std::numeric_limits<f32>::max();
+                for (u64 k = 0; k < Quadrature::count; ++k)
+                {
+                    if (evaluated[k])
+                    {
+                        upper = T[k];
+                        inner += Quadrature::weights[k] * T[k];
+                        continue;
+                    }
+                    /// the transmittance is at most 1 in front of the origin
+                    const f32 upper_k = std::min(upper, s[k] >= 0.f ? 1.f : std::numeric_limits<f32>::max());
+                    f32 lower_k = 0.f;
+                    for (u64 l = k + 1; l < Quadrature::count; ++l)
+                        if (evaluated[l]) { lower_k = T[l]; break; }
+                    const f32 e = Quadrature::weights[k] * (upper_k - lower_k);
+                    inner += Quadrature::weights[k] * (upper_k + lower_k) * .5f;
+                    error += e * .5f;
+                    if (e > max_error)
+                    {
+                        max_error = e;
+                        next = k;
+                    }
+                }
+                if (error <= tolerance) break;
             }
-            L_hat = L_hat + (G_q.albedo * inner);
+            L_hat = L_hat + (G_q.albedo * (scale * inner));
         }
+        adaptive_quadrature.samples += samples;
+        adaptive_quadrature.pairs += params.count;
         return L_hat;
     }
 
 
     /// Renders an image with dimensions `width` x `height` of the given `gaussians` into `image`.
-    template<radiance_func_t Radiance = radiance>
+    template<typename Quadrature = riemann_quadrature_t, radiance_func_t Radiance = fused_radiance<simd::exp, simd::erf, expf, Quadrature>>
     bool render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t &origin, const gaussians_t &gaussians, const bool &running = true)
     {
         for (u64 i = 0; i < width * height; ++i)
@@ -243,12 +1654,13 @@ namespace vrt
             image[i] = A | R << 16 | G << 8 | B;
             if (!running) return true;
         }
+        sample_culling.flush();
         return false;
     }
 
     /// Renders an image with dimensions `width` x `height` of the given `gaussians` into `image`.
     /// This version of the function takes a tiled set of gaussians.
-    template<radiance_func_t Radiance = radiance>
+    template<typename Quadrature = riemann_quadrature_t, radiance_func_t Radiance = fused_radiance<simd::exp, simd::erf, expf, Quadrature>>
     bool render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t &origin, const tiles_t &tiles, const bool &running, const u64 tc)
     {
         const u64 tile_width = width * tiles.tw/2.f;
@@ -283,6 +1695,7 @@ namespace vrt
                             img[_i] = (A | R << 16 | G << 8 | B);
                         }
                         delete g.soa_gaussians;
+                        sample_culling.flush();
                     };
                 if (tc == 1) {
                     task();
@@ -309,30 +1722,86 @@ namespace vrt
         return false;
     }
 
+    /// Loads the points on the projection plane of a packet of `PacketWidth` x `SIMD_FLOATS / PacketWidth` pixels.
+    /// \param cam the camera holding the projection plane.
+    /// \param i index of the top left pixel of the packet.
+    /// \param stride the number of pixels per row of the projection plane.
+    template<u64 PacketWidth = SIMD_FLOATS>
+    inline simd_vec4f_t load_packet(const camera_t &cam, const u64 i, const u64 stride)
+    {
+        if constexpr (PacketWidth == SIMD_FLOATS)
+        {
+            return simd_vec4f_t{
+                .x = simd::load(cam.projection_plane.xs + i),
+                    .y = simd::load(cam.projection_plane.ys + i),
+                    .z = simd::load(cam.projection_plane.zs + i)
+            };
+        }
+        alignas(NATIVE_SIMD_WIDTH) f32 xs[SIMD_FLOATS], ys[SIMD_FLOATS], zs[SIMD_FLOATS];
+        for (u64 r = 0; r < SIMD_FLOATS / PacketWidth; ++r)
+        {
+            for (u64 c = 0; c < PacketWidth; ++c)
+            {
+                xs[r * PacketWidth + c] = cam.projection_plane.xs[i + r * stride + c];
+                ys[r * PacketWidth + c] = cam.projection_plane.ys[i + r * stride + c];
+                zs[r * PacketWidth + c] = cam.projection_plane.zs[i + r * stride + c];
+            }
+        }
+        return simd_vec4f_t{ .x = simd::load(xs), .y = simd::load(ys), .z = simd::load(zs) };
+    }
+
+    /// Stores the pixels of a packet of `PacketWidth` x `SIMD_FLOATS / PacketWidth` pixels into `image`.
+    /// \param image the image to write into.
+    /// \param i index of the top left pixel of the packet.
+    /// \param stride the number of pixels per row of `image`.
+    /// \param pixels the pixels of the packet in row major order.
+    template<u64 PacketWidth = SIMD_FLOATS>
+    inline void store_packet(i32 *image, const u64 i, const u64 stride, const simd::Vec<simd::Int> &pixels)
+    {
+        if constexpr (PacketWidth == SIMD_FLOATS)
+        {
+            simd::store(image + i, pixels);
+            return;
+        }
+        alignas(NATIVE_SIMD_WIDTH) i32 ps[SIMD_FLOATS];
+        simd::store(ps, pixels);
+        for (u64 r = 0; r < SIMD_FLOATS / PacketWidth; ++r)
+            memcpy(image + i + r * stride, ps + r * PacketWidth, sizeof(i32) * PacketWidth);
+    }
+
     /// Renders an image with dimensions `width` x `height` of the given `gaussians` into `image`.
     /// This function is parallelized along the image pixels.
     /// Requires `image`, `xs` and `ys` to be aligned to `NATIVE_SIMD_WIDTH`.
-    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
+    /// The pixels are processed in packets of `PacketWidth` x `SIMD_FLOATS / PacketWidth` pixels. Square packets are more
+    /// coherent, which benefits radiance functions that exploit the coherence of the rays such as culling per packet.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t,
+        broadcast_radiance_func_t Radiance = broadcast_radiance<Exp, Erf, Quadrature>,
+        u64 PacketWidth = SIMD_FLOATS>
     bool simd_render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t &origin, const gaussians_t &gaussians, const bool &running = true)
     {
+        static_assert(SIMD_FLOATS % PacketWidth == 0);
+        constexpr u64 packet_height = SIMD_FLOATS / PacketWidth;
+        ASSERT((width % PacketWidth == 0 && height % packet_height == 0));
         const simd_vec4f_t simd_origin = simd_vec4f_t::from_vec4f_t(origin);
 
-        for (u64 i = 0; i < width * height; i += SIMD_FLOATS)
+        for (u64 y = 0; y < height; y += packet_height)
         {
-            simd_vec4f_t dir = simd_vec4f_t{
-                .x = simd::load(cam.projection_plane.xs + i),
-                    .y = simd::load(cam.projection_plane.ys + i),
-                    .z = simd::load(cam.projection_plane.zs + i)
-            } - simd_origin;
-            dir.normalize();
-            const simd_vec4f_t color = broadcast_radiance<Exp, Erf>(simd_origin, dir, gaussians);
-            const simd::Vec<simd::Int> A = simd::set1<simd::Int>(0xFF000000);
-            const simd::Vec<simd::Int> R = simd::cvts<simd::Int>(simd::min(color.x, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
-            const simd::Vec<simd::Int> G = simd::cvts<simd::Int>(simd::min(color.y, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
-            const simd::Vec<simd::Int> B = simd::cvts<simd::Int>(simd::min(color.z, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
-            simd::store((i32*)image + i, (A | simd::slli<16>(R) | simd::slli<8>(G) | B));
-            if (!running) return true;
+            for (u64 x = 0; x < width; x += PacketWidth)
+            {
+                const u64 i = y * width + x;
+                simd_vec4f_t dir = load_packet<PacketWidth>(cam, i, width) - simd_origin;
+                dir.normalize();
+                stochastic_transmittance.packet = pixel_packet_t{ .first = i, .stride = width, .width = PacketWidth };
+                const simd_vec4f_t color = Radiance(simd_origin, dir, gaussians);
+                const simd::Vec<simd::Int> A = simd::set1<simd::Int>(0xFF000000);
+                const simd::Vec<simd::Int> R = simd::cvts<simd::Int>(simd::min(color.x, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+                const simd::Vec<simd::Int> G = simd::cvts<simd::Int>(simd::min(color.y, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+                const simd::Vec<simd::Int> B = simd::cvts<simd::Int>(simd::min(color.z, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+                store_packet<PacketWidth>((i32*)image, i, width, (A | simd::slli<16>(R) | simd::slli<8>(G) | B));
+                if (!running) return true;
+            }
         }
+        sample_culling.flush();
         return false;
     }
 
@@ -340,14 +1809,23 @@ namespace vrt
     /// This function is parallelized along the image pixels.
     /// Requires `image` to be aligned to `NATIVE_SIMD_WIDTH`.
     /// This version of the function takes a tiled set of gaussians.
-    /// The width of the tiles needs to be a multiple of `SIMD_FLOATS`.
-    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf>
+    /// The width of the tiles needs to be a multiple of `SIMD_FLOATS` and their height a multiple of the packet height.
+    /// The tiles are classified before rendering. Empty tiles are not rendered but filled with the background, tiles with
+    /// at most `CLOSED_FORM_MAX_GAUSSIANS` gaussians use `closed_form_broadcast_radiance` if `Radiance` is the default
+    /// `broadcast_radiance`, and all other tiles use `Radiance`.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t,
+        broadcast_radiance_func_t Radiance = broadcast_radiance<Exp, Erf, Quadrature>,
+        u64 PacketWidth = SIMD_FLOATS>
     bool simd_render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t origin, const tiles_t &tiles,
             const bool &running, const u64 tc)
     {
+        constexpr bool closed_form = Radiance == broadcast_radiance<Exp, Erf, Quadrature>;
+        static_assert(SIMD_FLOATS % PacketWidth == 0);
+        constexpr u64 packet_height = SIMD_FLOATS / PacketWidth;
         const u64 tile_width = width * tiles.tw/2.f;
         const u64 tile_height = height * tiles.th/2.f;
         ASSERT((tile_width % SIMD_FLOATS == 0));
+        ASSERT((tile_height % packet_height == 0));
         const simd_vec4f_t simd_origin = simd_vec4f_t::from_vec4f_t(origin);
 
         std::vector<i32*> tile_buffers;
@@ -355,27 +1833,217 @@ namespace vrt
             std::unique_ptr<thread_pool_t> tp = (tc == 1) ? nullptr : std::make_unique<thread_pool_t>(tc);
             for (u64 tidx = 0; tidx < tiles.w * tiles.h; ++tidx)
             {
+                /// the radiance of a ray without gaussians is zero in all channels, so empty tiles are not rendered
+                if (tiles.gaussians[tidx].gaussians.empty())
+                {
+                    tile_buffers.push_back(nullptr);
+                    continue;
+                }
                 tile_buffers.push_back((i32*)simd::aligned_malloc(sizeof(i32) * tile_width * tile_height));
-                /// NOTE: apparently i can not share the tiles object across multiple threads to access the gaussians
-                gaussians_t g{ tiles.gaussians[tidx].gaussians };
-                std::function<void()> task = [img{tile_buffers[tidx]}, tidx, tile_width, tile_height, g, &tiles, &cam, &simd_origin] () {
-                    for (u64 _i = 0; _i < tile_width * tile_height; _i += SIMD_FLOATS)
+                /// NOTE: the tasks copy the AoS gaussians of their tile but share its SoA gaussians, which are only read
+                gaussians_t g{ tiles.gaussians[tidx].gaussians, tiles.gaussians[tidx].soa_gaussians };
+                const broadcast_radiance_func_t radiance = (closed_form && g.gaussians.size() <= CLOSED_FORM_MAX_GAUSSIANS)
+                    ? closed_form_broadcast_radiance<Exp, Erf, Quadrature> : Radiance;
+                std::function<void()> task = [img{tile_buffers[tidx]}, tidx, tile_width, tile_height, g, radiance, &tiles, &cam, &simd_origin] () {
+                    for (u64 y = 0; y < tile_height; y += packet_height)
+                    {
+                        for (u64 x = 0; x < tile_width; x += PacketWidth)
+                        {
+                            const u64 _i = y * tile_width + x;
+                            const u64 i = (tidx % tiles.w) * tile_width + x // horizontal position
+                                + (tile_width * tiles.w) * (y + (tidx/tiles.w) * tile_height); // vertical position
+                            simd_vec4f_t dir = load_packet<PacketWidth>(cam, i, tile_width * tiles.w) - simd_origin;
+                            dir.normalize();
+                            stochastic_transmittance.packet = pixel_packet_t{ .first = i, .stride = tile_width * tiles.w, .width = PacketWidth };
+                            simd_vec4f_t color = radiance(simd_origin, dir, g);
+                            simd::Vec<simd::Int> A = simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.w) * simd::set1<simd::Float>(255.f));
+                            simd::Vec<simd::Int> R = simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.x) * simd::set1<simd::Float>(255.f));
+                            simd::Vec<simd::Int> G = simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.y) * simd::set1<simd::Float>(255.f));
+                            simd::Vec<simd::Int> B = simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.z) * simd::set1<simd::Float>(255.f));
+                            store_packet<PacketWidth>(img, _i, tile_width, (simd::slli<24>(A) | simd::slli<16>(R) | simd::slli<8>(G) | B));
+                        }
+                    }
+                    sample_culling.flush();
+                };
+                if (tc == 1) {
+                    task();
+                    if (!running) return true;
+                }
+                else tp->enqueue(task);
+            }
+        } // NOTE: end of the scope implicitly joins threads through destructor
+
+        /// NOTE: the background of the empty tiles is never read again, so it bypasses the cache with streaming stores
+        const simd::Vec<simd::Int> background = simd::set1<simd::Int>(0);
+        for (u64 tidx = 0; tidx < tiles.w * tiles.h; ++tidx)
+        {
+            i32 *img = tile_buffers[tidx];
+            for (u64 _i = 0; _i < tile_width * tile_height; _i += SIMD_FLOATS)
+            {
+                const u64 i = (tidx % tiles.w) * tile_width + _i % tile_width // horizontal position
+                    + (tile_width * tiles.w) * (_i/tile_width + (tidx/tiles.w) * tile_height); // vertical positiona
+                if (img == nullptr)
+                {
+                    simd::stream_store((i32*)image + i, background);
+                    continue;
+                }
+                simd::Vec<simd::Int> d = simd::load(img + _i);
+                simd::store((i32*)image + i, d);
+            }
+            if (img) simd::aligned_free(img);
+        }
+        simd::sfence();
+        tile_buffers.clear();
+
+        if (!running) return true;
+        return false;
+    }
+
+    /// Renders an image with dimensions `width` x `height` of the given variable size tiles into `image` like the version
+    /// of `simd_render_image` that takes uniform tiles. The tiles cover disjoint pixels, so they are written into the
+    /// image directly.
+    /// The sides of the tiles need to be multiples of `SIMD_FLOATS`, see `quadtree_tile_gaussians`.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t,
+        broadcast_radiance_func_t Radiance = broadcast_radiance<Exp, Erf, Quadrature>,
+        u64 PacketWidth = SIMD_FLOATS>
+    bool simd_render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t origin, const quadtree_tiles_t &tiles,
+            const bool &running, const u64 tc)
+    {
+        static_assert(SIMD_FLOATS % PacketWidth == 0);
+        constexpr u64 packet_height = SIMD_FLOATS / PacketWidth;
+        const simd_vec4f_t simd_origin = simd_vec4f_t::from_vec4f_t(origin);
+
+        std::unique_ptr<thread_pool_t> tp = (tc == 1) ? nullptr : std::make_unique<thread_pool_t>(tc);
+        for (const quadtree_tile_t &tile : tiles.tiles)
+        {
+            ASSERT((tile.w % PacketWidth == 0 && tile.h % packet_height == 0));
+            std::function<void()> task = [&tile, width, image, &cam, &simd_origin] () {
+                for (u64 y = tile.y; y < tile.y + tile.h; y += packet_height)
+                {
+                    for (u64 x = tile.x; x < tile.x + tile.w; x += PacketWidth)
                     {
-                        const u64 i = (tidx % tiles.w) * tile_width + _i % tile_width // horizontal position
-                            + (tile_width * tiles.w) * (_i/tile_width + (tidx/tiles.w) * tile_height); // vertical position
-                        simd_vec4f_t dir = simd_vec4f_t{
-                            .x = simd::load(cam.projection_plane.xs + i),
-                                .y = simd::load(cam.projection_plane.ys + i),
-                                .z = simd::load(cam.projection_plane.zs + i)
-                        } - simd_origin;
+                        const u64 i = y * width + x;
+                        simd_vec4f_t dir = load_packet<PacketWidth>(cam, i, width) - simd_origin;
                         dir.normalize();
-                        simd_vec4f_t color = broadcast_radiance<Exp, Erf>(simd_origin, dir, g);
+                        stochastic_transmittance.packet = pixel_packet_t{ .first = i, .stride = width, .width = PacketWidth };
+                        simd_vec4f_t color = Radiance(simd_origin, dir, tile.gaussians);
                         simd::Vec<simd::Int> A = simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.w) * simd::set1<simd::Float>(255.f));
                         simd::Vec<simd::Int> R = simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.x) * simd::set1<simd::Float>(255.f));
                         simd::Vec<simd::Int> G = simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.y) * simd::set1<simd::Float>(255.f));
                         simd::Vec<simd::Int> B = simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.z) * simd::set1<simd::Float>(255.f));
-                        simd::store(img + _i, (simd::slli<24>(A) | simd::slli<16>(R) | simd::slli<8>(G) | B));
+                        store_packet<PacketWidth>((i32*)image, i, width, (simd::slli<24>(A) | simd::slli<16>(R) | simd::slli<8>(G) | B));
                     }
+                }
+                sample_culling.flush();
+            };
+            if (tc == 1) {
+                task();
+                if (!running) return true;
+            }
+            else tp->enqueue(task);
+        }
+        tp.reset(); // NOTE: joins the threads through the destructor
+
+        if (!running) return true;
+        return false;
+    }
+
+    /// Renders the `tile_width` x `tile_height` pixels starting at (`x0`, `y0`) of the projection plane of `cam` like
+    /// `simd_render_image` with `blocked_broadcast_radiance`, but projects the gaussians onto the rays of the tile once
+    /// at its corner and evaluates the projections per packet from the pixel offsets, see `precompute_plane_ray_params`.
+    /// \param image the buffer to write the pixels of the tile into.
+    /// \param stride the number of pixels per row of `image`.
+    /// Stores the accumulated alpha of the pixels if `Alpha` is set and opaque pixels otherwise.
+    /// Returns whether the rendering was interrupted.
+    template<simd_f32_func_t Exp, simd_f32_func_t Erf, typename Quadrature, u64 PacketWidth, bool Alpha>
+    bool incremental_render_tile(const camera_t &cam, const vec4f_t &origin, const gaussians_t &gaussians, const u64 x0, const u64 y0,
+            const u64 tile_width, const u64 tile_height, i32 *image, const u64 stride, const bool &running)
+    {
+        static_assert(SIMD_FLOATS % PacketWidth == 0);
+        constexpr u64 packet_height = SIMD_FLOATS / PacketWidth;
+        /// NOTE: one scratch buffer per thread since the tiles are rendered in parallel
+        static thread_local plane_params_vec_t plane;
+        static thread_local ray_params_vec_t params;
+
+        /// NOTE: the projection plane is the image of the normalized device coordinates under the inverse view matrix,
+        /// see `camera_t::update`, so it is affine in the pixel position
+        const glm::mat4 inv_view = glm::inverse(cam.view_matrix);
+        const glm::vec3 dx = glm::vec3(inv_view[0]) * (2.f / cam.w);
+        const glm::vec3 dy = glm::vec3(inv_view[1]) * (2.f / cam.h);
+        const u64 c = y0 * cam.w + x0;
+        const glm::vec3 corner(cam.projection_plane.xs[c] - origin.x, cam.projection_plane.ys[c] - origin.y, cam.projection_plane.zs[c] - origin.z);
+        precompute_plane_params(origin, corner, dx, dy, gaussians, plane);
+
+        alignas(NATIVE_SIMD_WIDTH) f32 lane_x[SIMD_FLOATS], lane_y[SIMD_FLOATS];
+        for (u64 l = 0; l < SIMD_FLOATS; ++l)
+        {
+            lane_x[l] = l % PacketWidth;
+            lane_y[l] = l / PacketWidth;
+        }
+        const simd::Vec<simd::Float> zero = simd::set1<simd::Float>(0.f);
+        const simd_vec4f_t simd_corner{ .x = simd::set1<simd::Float>(corner.x), .y = simd::set1<simd::Float>(corner.y), .z = simd::set1<simd::Float>(corner.z), .w = zero };
+        const simd_vec4f_t simd_dx{ .x = simd::set1<simd::Float>(dx.x), .y = simd::set1<simd::Float>(dx.y), .z = simd::set1<simd::Float>(dx.z), .w = zero };
+        const simd_vec4f_t simd_dy{ .x = simd::set1<simd::Float>(dy.x), .y = simd::set1<simd::Float>(dy.y), .z = simd::set1<simd::Float>(dy.z), .w = zero };
+
+        for (u64 y = 0; y < tile_height; y += packet_height)
+        {
+            const simd::Vec<simd::Float> ys = simd::set1<simd::Float>(y) + simd::load(lane_y);
+            for (u64 x = 0; x < tile_width; x += PacketWidth)
+            {
+                const simd::Vec<simd::Float> xs = simd::set1<simd::Float>(x) + simd::load(lane_x);
+                const simd_vec4f_t dir = simd_corner + simd_dx * xs + simd_dy * ys;
+                const simd::Vec<simd::Float> inv_length = simd::set1<simd::Float>(1.f) / simd::sqrt(dir.sqnorm());
+                precompute_plane_ray_params<Exp, Erf>(xs, ys, inv_length, gaussians, plane, params);
+                const simd_vec4f_t color = blocked_radiance<Exp, Erf, Quadrature, 1, BLOCKED_GAUSSIANS>(gaussians, { &params })[0];
+                simd::Vec<simd::Int> A = simd::set1<simd::Int>(0xFF000000);
+                if constexpr (Alpha)
+                    A = simd::slli<24>(simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.w) * simd::set1<simd::Float>(255.f)));
+                const simd::Vec<simd::Int> R = simd::cvts<simd::Int>(simd::min(color.x, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+                const simd::Vec<simd::Int> G = simd::cvts<simd::Int>(simd::min(color.y, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+                const simd::Vec<simd::Int> B = simd::cvts<simd::Int>(simd::min(color.z, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+                store_packet<PacketWidth>(image, y * stride + x, stride, (A | simd::slli<16>(R) | simd::slli<8>(G) | B));
+                if (!running) return true;
+            }
+        }
+        sample_culling.flush();
+        return false;
+    }
+
+    /// Renders an image with dimensions `width` x `height` of the given `gaussians` into `image` like `simd_render_image`
+    /// with `blocked_broadcast_radiance`, but without the dot products and norms per gaussian and packet, see
+    /// `incremental_render_tile`.
+    /// Requires `image` to be aligned to `NATIVE_SIMD_WIDTH`.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t, u64 PacketWidth = SIMD_FLOATS>
+    bool incremental_render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t &origin, const gaussians_t &gaussians, const bool &running = true)
+    {
+        ASSERT((width % PacketWidth == 0 && height % (SIMD_FLOATS / PacketWidth) == 0));
+        return incremental_render_tile<Exp, Erf, Quadrature, PacketWidth, false>(cam, origin, gaussians, 0, 0, width, height, (i32*)image, width, running);
+    }
+
+    /// Renders an image with dimensions `width` x `height` of the given `gaussians` into `image`, see
+    /// `incremental_render_tile`. The gaussians are projected onto the rays once per tile.
+    /// Requires `image` to be aligned to `NATIVE_SIMD_WIDTH`.
+    /// This version of the function takes a tiled set of gaussians.
+    /// The width of the tiles needs to be a multiple of `SIMD_FLOATS` and their height a multiple of the packet height.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t, u64 PacketWidth = SIMD_FLOATS>
+    bool incremental_render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t origin, const tiles_t &tiles,
+            const bool &running, const u64 tc)
+    {
+        const u64 tile_width = width * tiles.tw/2.f;
+        const u64 tile_height = height * tiles.th/2.f;
+        ASSERT((tile_width % SIMD_FLOATS == 0));
+        ASSERT((tile_height % (SIMD_FLOATS / PacketWidth) == 0));
+
+        std::vector<i32*> tile_buffers;
+        {
+            std::unique_ptr<thread_pool_t> tp = (tc == 1) ? nullptr : std::make_unique<thread_pool_t>(tc);
+            for (u64 tidx = 0; tidx < tiles.w * tiles.h; ++tidx)
+            {
+                tile_buffers.push_back((i32*)simd::aligned_malloc(sizeof(i32) * tile_width * tile_height));
+                gaussians_t g{ tiles.gaussians[tidx].gaussians, tiles.gaussians[tidx].soa_gaussians };
+                std::function<void()> task = [img{tile_buffers[tidx]}, tidx, tile_width, tile_height, g, &tiles, &cam, &origin, &running] () {
+                    incremental_render_tile<Exp, Erf, Quadrature, PacketWidth, true>(cam, origin, g, (tidx % tiles.w) * tile_width,
+                            (tidx / tiles.w) * tile_height, tile_width, tile_height, img, tile_width, running);
                 };
                 if (tc == 1) {
                     task();
@@ -391,7 +2059,7 @@ namespace vrt
             for (u64 _i = 0; _i < tile_width * tile_height; _i += SIMD_FLOATS)
             {
                 const u64 i = (tidx % tiles.w) * tile_width + _i % tile_width // horizontal position
-                    + (tile_width * tiles.w) * (_i/tile_width + (tidx/tiles.w) * tile_height); // vertical positiona
+                    + (tile_width * tiles.w) * (_i/tile_width + (tidx/tiles.w) * tile_height); // vertical position
                 simd::Vec<simd::Int> d = simd::load(img + _i);
                 simd::store((i32*)image + i, d);
             }
@@ -399,6 +2067,148 @@ namespace vrt
         }
         tile_buffers.clear();
 
+        if (!running) return true;
+        return false;
+    }
+    /// Renders `Packets` horizontally neighbouring packets of `PacketWidth` x `SIMD_FLOATS / PacketWidth` pixels with
+    /// one call of `packet_blocked_broadcast_radiance`.
+    /// \param i index of the top left pixel of the first packet on the projection plane of `cam`.
+    /// \param plane_stride the number of pixels per row of the projection plane.
+    /// \param image the buffer to write the pixels into.
+    /// \param j index of the top left pixel of the first packet in `image`.
+    /// \param stride the number of pixels per row of `image`.
+    /// Stores the accumulated alpha of the pixels if `Alpha` is set and opaque pixels otherwise.
+    template<simd_f32_func_t Exp, simd_f32_func_t Erf, typename Quadrature, u64 Packets, u64 Block, u64 PacketWidth, bool Alpha>
+    void blocked_render_packets(const camera_t &cam, const simd_vec4f_t &origin, const gaussians_t &gaussians, const u64 i, const u64 plane_stride,
+            i32 *image, const u64 j, const u64 stride)
+    {
+        std::array<simd_vec4f_t, Packets> dirs;
+        for (u64 r = 0; r < Packets; ++r)
+        {
+            dirs[r] = load_packet<PacketWidth>(cam, i + r * PacketWidth, plane_stride) - origin;
+            dirs[r].normalize();
+        }
+        const std::array<simd_vec4f_t, Packets> colors = packet_blocked_broadcast_radiance<Exp, Erf, Quadrature, Packets, Block>(origin, dirs, gaussians);
+        for (u64 r = 0; r < Packets; ++r)
+        {
+            const simd_vec4f_t &color = colors[r];
+            simd::Vec<simd::Int> A = simd::set1<simd::Int>(0xFF000000);
+            if constexpr (Alpha)
+                A = simd::slli<24>(simd::cvts<simd::Int>(simd::min(simd::set1<simd::Float>(1.f), color.w) * simd::set1<simd::Float>(255.f)));
+            const simd::Vec<simd::Int> R = simd::cvts<simd::Int>(simd::min(color.x, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+            const simd::Vec<simd::Int> G = simd::cvts<simd::Int>(simd::min(color.y, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+            const simd::Vec<simd::Int> B = simd::cvts<simd::Int>(simd::min(color.z, simd::set1<simd::Float>(1.f)) * simd::set1<simd::Float>(255.f));
+            store_packet<PacketWidth>(image, j + r * PacketWidth, stride, (A | simd::slli<16>(R) | simd::slli<8>(G) | B));
+        }
+    }
+
+    /// Renders the `tile_width` x `tile_height` pixels starting at pixel `first` of the projection plane of `cam` like
+    /// `simd_render_image` with `blocked_broadcast_radiance`, but hands `Packets` packets of a row of the tile to each call
+    /// of the radiance, see `packet_blocked_broadcast_radiance`. The remaining packets of a row are rendered one by one.
+    /// \param plane_stride the number of pixels per row of the projection plane.
+    /// \param image the buffer to write the pixels of the tile into.
+    /// \param stride the number of pixels per row of `image`.
+    /// Stores the accumulated alpha of the pixels if `Alpha` is set and opaque pixels otherwise.
+    /// Returns whether the rendering was interrupted.
+    template<simd_f32_func_t Exp, simd_f32_func_t Erf, typename Quadrature, u64 Packets, u64 Block, u64 PacketWidth, bool Alpha>
+    bool blocked_render_tile(const camera_t &cam, const simd_vec4f_t &origin, const gaussians_t &gaussians, const u64 first, const u64 plane_stride,
+            const u64 tile_width, const u64 tile_height, i32 *image, const u64 stride, const bool &running)
+    {
+        static_assert(SIMD_FLOATS % PacketWidth == 0);
+        constexpr u64 packet_height = SIMD_FLOATS / PacketWidth;
+        for (u64 y = 0; y < tile_height; y += packet_height)
+        {
+            u64 x = 0;
+            for (; x + Packets * PacketWidth <= tile_width; x += Packets * PacketWidth)
+            {
+                blocked_render_packets<Exp, Erf, Quadrature, Packets, Block, PacketWidth, Alpha>(cam, origin, gaussians, first + y * plane_stride + x,
+                        plane_stride, image, y * stride + x, stride);
+                if (!running) return true;
+            }
+            for (; x < tile_width; x += PacketWidth)
+            {
+                blocked_render_packets<Exp, Erf, Quadrature, 1, Block, PacketWidth, Alpha>(cam, origin, gaussians, first + y * plane_stride + x,
+                        plane_stride, image, y * stride + x, stride);
+                if (!running) return true;
+            }
+        }
+        sample_culling.flush();
+        return false;
+    }
+
+    /// Renders an image with dimensions `width` x `height` of the given `gaussians` into `image` like `simd_render_image`
+    /// with `blocked_broadcast_radiance`, but with `Packets` packets of rays per call, see `blocked_render_tile`.
+    /// Requires `image` to be aligned to `NATIVE_SIMD_WIDTH`.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t,
+        u64 Packets = BLOCKED_PACKETS, u64 Block = BLOCKED_GAUSSIANS, u64 PacketWidth = SIMD_FLOATS>
+    bool blocked_render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t &origin, const gaussians_t &gaussians, const bool &running = true)
+    {
+        ASSERT((width % PacketWidth == 0 && height % (SIMD_FLOATS / PacketWidth) == 0));
+        return blocked_render_tile<Exp, Erf, Quadrature, Packets, Block, PacketWidth, false>(cam, simd_vec4f_t::from_vec4f_t(origin), gaussians, 0, width,
+                width, height, (i32*)image, width, running);
+    }
+
+    /// Renders an image with dimensions `width` x `height` of the given `gaussians` into `image`, see
+    /// `blocked_render_tile`. Empty tiles are not rendered but filled with the background.
+    /// Requires `image` to be aligned to `NATIVE_SIMD_WIDTH`.
+    /// This version of the function takes a tiled set of gaussians.
+    /// The width of the tiles needs to be a multiple of `SIMD_FLOATS` and their height a multiple of the packet height.
+    template<simd_f32_func_t Exp = simd::exp, simd_f32_func_t Erf = simd::erf, typename Quadrature = riemann_quadrature_t,
+        u64 Packets = BLOCKED_PACKETS, u64 Block = BLOCKED_GAUSSIANS, u64 PacketWidth = SIMD_FLOATS>
+    bool blocked_render_image(const u32 width, const u32 height, u32 *image, const camera_t &cam, const vec4f_t origin, const tiles_t &tiles,
+            const bool &running, const u64 tc)
+    {
+        const u64 tile_width = width * tiles.tw/2.f;
+        const u64 tile_height = height * tiles.th/2.f;
+        ASSERT((tile_width % SIMD_FLOATS == 0));
+        ASSERT((tile_height % (SIMD_FLOATS / PacketWidth) == 0));
+        const simd_vec4f_t simd_origin = simd_vec4f_t::from_vec4f_t(origin);
+
+        std::vector<i32*> tile_buffers;
+        {
+            std::unique_ptr<thread_pool_t> tp = (tc == 1) ? nullptr : std::make_unique<thread_pool_t>(tc);
+            for (u64 tidx = 0; tidx < tiles.w * tiles.h; ++tidx)
+            {
+                if (tiles.gaussians[tidx].gaussians.empty())
+                {
+                    tile_buffers.push_back(nullptr);
+                    continue;
+                }
+                tile_buffers.push_back((i32*)simd::aligned_malloc(sizeof(i32) * tile_width * tile_height));
+                gaussians_t g{ tiles.gaussians[tidx].gaussians, tiles.gaussians[tidx].soa_gaussians };
+                std::function<void()> task = [img{tile_buffers[tidx]}, tidx, tile_width, tile_height, g, &tiles, &cam, &simd_origin, &running] () {
+                    const u64 first = (tidx % tiles.w) * tile_width + (tile_width * tiles.w) * (tidx / tiles.w) * tile_height;
+                    blocked_render_tile<Exp, Erf, Quadrature, Packets, Block, PacketWidth, true>(cam, simd_origin, g, first, tile_width * tiles.w,
+                            tile_width, tile_height, img, tile_width, running);
+                };
+                if (tc == 1) {
+                    task();
+                    if (!running) return true;
+                }
+                else tp->enqueue(task);
+            }
+        } // NOTE: end of the scope implicitly joins threads through destructor
+
+        const simd::Vec<simd::Int> background = simd::set1<simd::Int>(0);
+        for (u64 tidx = 0; tidx < tiles.w * tiles.h; ++tidx)
+        {
+            i32 *img = tile_buffers[tidx];
+            for (u64 _i = 0; _i < tile_width * tile_height; _i += SIMD_FLOATS)
+            {
+                const u64 i = (tidx % tiles.w) * tile_width + _i % tile_width // horizontal position
+                    + (tile_width * tiles.w) * (_i/tile_width + (tidx/tiles.w) * tile_height); // vertical position
+                if (img == nullptr)
+                {
+                    simd::stream_store((i32*)image + i, background);
+                    continue;
+                }
+                simd::store((i32*)image + i, simd::load(img + _i));
+            }
+            if (img) simd::aligned_free(img);
+        }
+        simd::sfence();
+        tile_buffers.clear();
+
         if (!running) return true;
         return false;
     }
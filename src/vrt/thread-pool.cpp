@@ -1,4 +1,6 @@
 #include "thread-pool.h"
+#include <algorithm>
+#include <memory>
 
 thread_pool_t::thread_pool_t(u64 thread_count)
 {
@@ -25,3 +27,14 @@ thread_pool_t::~thread_pool_t()
     for (std::thread &t : this->threads)
         t.join();
 }
+
+void parallel_chunks(const u64 size, const u64 chunk, const u64 thread_count, const std::function<void(u64, u64)> &func)
+{
+    std::unique_ptr<thread_pool_t> tp = (thread_count <= 1 || size <= chunk) ? nullptr : std::make_unique<thread_pool_t>(thread_count);
+    for (u64 begin = 0; begin < size; begin += chunk)
+    {
+        const u64 end = std::min(begin + chunk, size);
+        if (tp) tp->enqueue([&func, begin, end] () { func(begin, end); });
+        else func(begin, end);
+    }
+} // NOTE: end of the scope implicitly joins threads through destructor
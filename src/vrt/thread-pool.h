@@ -33,3 +33,7 @@ struct thread_pool_t
     void enqueue(std::function<void()> task);
     ~thread_pool_t();
 };
+
+/// Runs `func(begin, end)` on the chunks of `chunk` elements of `[0, size)`. The chunks are distributed over
+/// `thread_count` threads, or run on the calling thread if there is only a single thread or chunk.
+void parallel_chunks(const u64 size, const u64 chunk, const u64 thread_count, const std::function<void(u64, u64)> &func);
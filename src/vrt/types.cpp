@@ -2,34 +2,81 @@
 
 namespace vrt
 {
+    /// Returns the rotation matrix of the unit quaternion `q` in row-major order.
+    static std::array<f32, 9> rotation_matrix(const vec4f_t &q)
+    {
+        return {
+            1.f - 2.f * (q.y * q.y + q.z * q.z), 2.f * (q.x * q.y - q.z * q.w), 2.f * (q.x * q.z + q.y * q.w),
+            2.f * (q.x * q.y + q.z * q.w), 1.f - 2.f * (q.x * q.x + q.z * q.z), 2.f * (q.y * q.z - q.x * q.w),
+            2.f * (q.x * q.z - q.y * q.w), 2.f * (q.y * q.z + q.x * q.w), 1.f - 2.f * (q.x * q.x + q.y * q.y)
+        };
+    }
+
+    /// Returns R * diag(d) * R^T packed as xx, xy, xz, yy, yz, zz for the rotation `R` of the gaussian.
+    static std::array<f32, 6> rotated_diagonal(const vec4f_t &q, const f32 d[3])
+    {
+        const std::array<f32, 9> R = rotation_matrix(q);
+        const auto entry = [&](const u64 r, const u64 c) {
+            return R[r * 3] * d[0] * R[c * 3] + R[r * 3 + 1] * d[1] * R[c * 3 + 1] + R[r * 3 + 2] * d[2] * R[c * 3 + 2];
+        };
+        return { entry(0, 0), entry(0, 1), entry(0, 2), entry(1, 1), entry(1, 2), entry(2, 2) };
+    }
+
+    std::array<f32, 6> gaussian_t::precision() const
+    {
+        const f32 inv_sigma2 = 1.f / (this->sigma * this->sigma);
+        if (this->is_isotropic()) return { inv_sigma2, 0.f, 0.f, inv_sigma2, 0.f, inv_sigma2 };
+        const f32 d[3] = { inv_sigma2 / (this->scale.x * this->scale.x), inv_sigma2 / (this->scale.y * this->scale.y), inv_sigma2 / (this->scale.z * this->scale.z) };
+        return rotated_diagonal(this->rotation, d);
+    }
+
+    f32 gaussian_t::variance(const vec4f_t &axis) const
+    {
+        const f32 sigma2 = this->sigma * this->sigma;
+        if (this->is_isotropic()) return sigma2 * (axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+        const f32 d[3] = { sigma2 * this->scale.x * this->scale.x, sigma2 * this->scale.y * this->scale.y, sigma2 * this->scale.z * this->scale.z };
+        const std::array<f32, 6> C = rotated_diagonal(this->rotation, d);
+        return C[0] * axis.x * axis.x + C[3] * axis.y * axis.y + C[5] * axis.z * axis.z
+            + 2.f * (C[1] * axis.x * axis.y + C[2] * axis.x * axis.z + C[4] * axis.y * axis.z);
+    }
+
+    std::array<f32**, 18> gaussian_vec_t::buffers()
+    {
+        return { &this->albedo.r, &this->albedo.g, &this->albedo.b, &this->mu.x, &this->mu.y, &this->mu.z, &this->sigma, &this->magnitude, &this->support,
+            &this->precision.xx, &this->precision.xy, &this->precision.xz, &this->precision.yy, &this->precision.yz, &this->precision.zz,
+            &this->inv_2_sigma2, &this->inv_sqrt_2_sigma, &this->weight_scale };
+    }
+
+    void gaussian_vec_t::store(const u64 i, const gaussian_t *g)
+    {
+        this->mu.x[i]      = g->mu.x;
+        this->mu.y[i]      = g->mu.y;
+        this->mu.z[i]      = g->mu.z;
+        this->albedo.r[i]  = g->albedo.x;
+        this->albedo.g[i]  = g->albedo.y;
+        this->albedo.b[i]  = g->albedo.z;
+        this->sigma[i]     = g->sigma;
+        this->magnitude[i] = g->magnitude;
+        this->support[i]   = g->support();
+        const std::array<f32, 6> P = g->precision();
+        this->precision.xx[i] = P[0];
+        this->precision.xy[i] = P[1];
+        this->precision.xz[i] = P[2];
+        this->precision.yy[i] = P[3];
+        this->precision.yz[i] = P[4];
+        this->precision.zz[i] = P[5];
+        this->inv_2_sigma2[i]     = 1.f / (2.f * g->sigma * g->sigma);
+        this->inv_sqrt_2_sigma[i] = 1.f / (SQRT_2 * g->sigma);
+        this->weight_scale[i]     = g->magnitude * g->sigma * INV_SQRT_2_PI;
+    }
+
     /// Loads gaussians from a given `std::vector<gaussian_t>`.
     /// Only loads `this->size` gaussians.
     /// Does not perform reallocations.
     void gaussian_vec_t::load_gaussians(const std::vector<gaussian_t> &gaussians)
     {
         for (u64 i = 0; i < this->size; ++i)
-        {
-            if (i >= gaussians.size())
-            {
-                this->mu.x[i]      = 0.f;
-                this->mu.y[i]      = 0.f;
-                this->mu.z[i]      = 0.f;
-                this->albedo.r[i]  = 0.f;
-                this->albedo.g[i]  = 0.f;
-                this->albedo.b[i]  = 0.f;
-                this->sigma[i]     = 1.f;
-                this->magnitude[i] = 0.f;
-                continue;
-            }
-            this->mu.x[i]      = gaussians[i].mu.x;
-            this->mu.y[i]      = gaussians[i].mu.y;
-            this->mu.z[i]      = gaussians[i].mu.z;
-            this->albedo.r[i]  = gaussians[i].albedo.x;
-            this->albedo.g[i]  = gaussians[i].albedo.y;
-            this->albedo.b[i]  = gaussians[i].albedo.z;
-            this->sigma[i]     = gaussians[i].sigma;
-            this->magnitude[i] = gaussians[i].magnitude;
-        }
+            this->store(i, &gaussians[i]);
     }
 
     /// Creates a new `gaussian_vec_t` from a given `std::vector<gaussian_t>`.
@@ -37,76 +84,132 @@ namespace vrt
     gaussian_vec_t *gaussian_vec_t::from_gaussians(const std::vector<gaussian_t> &gaussians)
     {
         gaussian_vec_t *vec = new gaussian_vec_t();
-        u64 size = ((gaussians.size() / SIMD_FLOATS) + 1) * SIMD_FLOATS;
-
-        vec->mu.x = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        vec->mu.y = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        vec->mu.z = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        vec->albedo.r = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        vec->albedo.g = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        vec->albedo.b = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        vec->sigma = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        vec->magnitude = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-
-        for (u64 i = 0; i < size; ++i)
-        {
-            if (i >= gaussians.size())
-            {
-                vec->mu.x[i]      = 0.f;
-                vec->mu.y[i]      = 0.f;
-                vec->mu.z[i]      = 0.f;
-                vec->albedo.r[i]  = 0.f;
-                vec->albedo.g[i]  = 0.f;
-                vec->albedo.b[i]  = 0.f;
-                vec->sigma[i]     = 1.f;
-                vec->magnitude[i] = 0.f;
-                continue;
-            }
-            vec->mu.x[i]      = gaussians[i].mu.x;
-            vec->mu.y[i]      = gaussians[i].mu.y;
-            vec->mu.z[i]      = gaussians[i].mu.z;
-            vec->albedo.r[i]  = gaussians[i].albedo.x;
-            vec->albedo.g[i]  = gaussians[i].albedo.y;
-            vec->albedo.b[i]  = gaussians[i].albedo.z;
-            vec->sigma[i]     = gaussians[i].sigma;
-            vec->magnitude[i] = gaussians[i].magnitude;
-        }
+        const u64 size = gaussians.size();
+        soa_padding.lanes += size;
+        soa_padding.previous_padding += (gaussians.size() / SIMD_FLOATS + 1) * SIMD_FLOATS - gaussians.size();
+
+        if (size > 0)
+            for (f32 **buffer : vec->buffers())
+                *buffer = (f32*)simd::aligned_malloc(sizeof(f32) * size);
         vec->size = size;
+        vec->capacity = size;
+        vec->load_gaussians(gaussians);
         return vec;
     }
 
     gaussian_vec_t::gaussian_vec_t(gaussian_vec_t &other)
     {
         this->size = other.size;
-        this->mu.x = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        memcpy(this->mu.x, other.mu.x, this->size * sizeof(f32));
-        this->mu.y = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        memcpy(this->mu.y, other.mu.y, this->size * sizeof(f32));
-        this->mu.z = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        memcpy(this->mu.z, other.mu.z, this->size * sizeof(f32));
-        this->albedo.r = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        memcpy(this->albedo.r, other.albedo.r, this->size * sizeof(f32));
-        this->albedo.g = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        memcpy(this->albedo.g, other.albedo.g, this->size * sizeof(f32));
-        this->albedo.b = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        memcpy(this->albedo.b, other.albedo.b, this->size * sizeof(f32));
-        this->sigma = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        memcpy(this->sigma, other.sigma, this->size * sizeof(f32));
-        this->magnitude = (f32*)simd::aligned_malloc(sizeof(f32) * size);
-        memcpy(this->magnitude, other.magnitude, this->size * sizeof(f32));
+        this->capacity = other.size;
+        if (this->size == 0) return;
+        const std::array<f32**, 18> src = other.buffers(), dst = this->buffers();
+        for (u64 b = 0; b < dst.size(); ++b)
+        {
+            *dst[b] = (f32*)simd::aligned_malloc(sizeof(f32) * size);
+            memcpy(*dst[b], *src[b], this->size * sizeof(f32));
+        }
     }
 
     /// Frees all allocated memory.
     gaussian_vec_t::~gaussian_vec_t()
     {
-        if (this->mu.x) simd::aligned_free(this->mu.x);
-        if (this->mu.y) simd::aligned_free(this->mu.y);
-        if (this->mu.z) simd::aligned_free(this->mu.z);
-        if (this->albedo.r) simd::aligned_free(this->albedo.r);
-        if (this->albedo.g) simd::aligned_free(this->albedo.g);
-        if (this->albedo.b) simd::aligned_free(this->albedo.b);
-        if (this->sigma) simd::aligned_free(this->sigma);
-        if (this->magnitude) simd::aligned_free(this->magnitude);
+        for (f32 **buffer : this->buffers())
+            if (*buffer) simd::aligned_free(*buffer);
+    }
+
+    /// Grows the buffers to hold at least `size` gaussians. Existing values are not preserved.
+    void ray_params_vec_t::reserve(const u64 size)
+    {
+        if (size <= this->capacity) return;
+        if (this->mu_bar) simd::aligned_free(this->mu_bar);
+        if (this->mu_bar_sqrt_2_sigma) simd::aligned_free(this->mu_bar_sqrt_2_sigma);
+        if (this->weight) simd::aligned_free(this->weight);
+        if (this->erf1) simd::aligned_free(this->erf1);
+        if (this->inv_sqrt_2_sigma) simd::aligned_free(this->inv_sqrt_2_sigma);
+        if (this->inv_sqrt_2_sigma_bar) simd::aligned_free(this->inv_sqrt_2_sigma_bar);
+        this->mu_bar = (f32*)simd::aligned_malloc(sizeof(f32) * size * SIMD_FLOATS);
+        this->mu_bar_sqrt_2_sigma = (f32*)simd::aligned_malloc(sizeof(f32) * size * SIMD_FLOATS);
+        this->weight = (f32*)simd::aligned_malloc(sizeof(f32) * size * SIMD_FLOATS);
+        this->erf1 = (f32*)simd::aligned_malloc(sizeof(f32) * size * SIMD_FLOATS);
+        this->inv_sqrt_2_sigma = (f32*)simd::aligned_malloc(sizeof(f32) * size);
+        this->inv_sqrt_2_sigma_bar = (f32*)simd::aligned_malloc(sizeof(f32) * size * SIMD_FLOATS);
+        this->capacity = size;
+    }
+
+    /// Frees all allocated memory.
+    ray_params_vec_t::~ray_params_vec_t()
+    {
+        if (this->mu_bar) simd::aligned_free(this->mu_bar);
+        if (this->mu_bar_sqrt_2_sigma) simd::aligned_free(this->mu_bar_sqrt_2_sigma);
+        if (this->weight) simd::aligned_free(this->weight);
+        if (this->erf1) simd::aligned_free(this->erf1);
+        if (this->inv_sqrt_2_sigma) simd::aligned_free(this->inv_sqrt_2_sigma);
+        if (this->inv_sqrt_2_sigma_bar) simd::aligned_free(this->inv_sqrt_2_sigma_bar);
+    }
+
+    /// Grows the buffers to hold at least `size` gaussians. Existing values are not preserved.
+    void plane_params_vec_t::reserve(const u64 size)
+    {
+        if (size <= this->capacity) return;
+        if (this->corner) simd::aligned_free(this->corner);
+        if (this->dx) simd::aligned_free(this->dx);
+        if (this->dy) simd::aligned_free(this->dy);
+        if (this->sqnorm) simd::aligned_free(this->sqnorm);
+        this->corner = (f32*)simd::aligned_malloc(sizeof(f32) * size);
+        this->dx = (f32*)simd::aligned_malloc(sizeof(f32) * size);
+        this->dy = (f32*)simd::aligned_malloc(sizeof(f32) * size);
+        this->sqnorm = (f32*)simd::aligned_malloc(sizeof(f32) * size);
+        this->capacity = size;
+    }
+
+    /// Frees all allocated memory.
+    plane_params_vec_t::~plane_params_vec_t()
+    {
+        if (this->corner) simd::aligned_free(this->corner);
+        if (this->dx) simd::aligned_free(this->dx);
+        if (this->dy) simd::aligned_free(this->dy);
+        if (this->sqnorm) simd::aligned_free(this->sqnorm);
+    }
+
+    /// Grows the buffers to hold at least `size` gaussians. Existing values are not preserved.
+    void sorted_params_vec_t::reserve(const u64 size)
+    {
+        if (size <= this->capacity) return;
+        const u64 padded = ((size + SIMD_FLOATS - 1) / SIMD_FLOATS + 1) * SIMD_FLOATS;
+        for (auto *arrays : { &this->unsorted, &this->sorted })
+        {
+            if (arrays->mu_bar) simd::aligned_free(arrays->mu_bar);
+            if (arrays->mu_bar_sqrt_2_sigma) simd::aligned_free(arrays->mu_bar_sqrt_2_sigma);
+            if (arrays->weight) simd::aligned_free(arrays->weight);
+            if (arrays->inv_sqrt_2_sigma) simd::aligned_free(arrays->inv_sqrt_2_sigma);
+            arrays->mu_bar = (f32*)simd::aligned_malloc(sizeof(f32) * padded);
+            arrays->mu_bar_sqrt_2_sigma = (f32*)simd::aligned_malloc(sizeof(f32) * padded);
+            arrays->weight = (f32*)simd::aligned_malloc(sizeof(f32) * padded);
+            arrays->inv_sqrt_2_sigma = (f32*)simd::aligned_malloc(sizeof(f32) * padded);
+        }
+        if (this->prefix_weight) simd::aligned_free(this->prefix_weight);
+        if (this->support_begin) simd::aligned_free(this->support_begin);
+        if (this->support_end) simd::aligned_free(this->support_end);
+        this->prefix_weight = (f32*)simd::aligned_malloc(sizeof(f32) * (padded + 1));
+        this->support_begin = (f32*)simd::aligned_malloc(sizeof(f32) * padded);
+        this->support_end = (f32*)simd::aligned_malloc(sizeof(f32) * padded);
+        this->order.resize(size);
+        this->capacity = size;
+    }
+
+    /// Frees all allocated memory.
+    sorted_params_vec_t::~sorted_params_vec_t()
+    {
+        for (auto *arrays : { &this->unsorted, &this->sorted })
+        {
+            if (arrays->mu_bar) simd::aligned_free(arrays->mu_bar);
+            if (arrays->mu_bar_sqrt_2_sigma) simd::aligned_free(arrays->mu_bar_sqrt_2_sigma);
+            if (arrays->weight) simd::aligned_free(arrays->weight);
+            if (arrays->inv_sqrt_2_sigma) simd::aligned_free(arrays->inv_sqrt_2_sigma);
+        }
+        if (this->prefix_weight) simd::aligned_free(this->prefix_weight);
+        if (this->support_begin) simd::aligned_free(this->support_begin);
+        if (this->support_end) simd::aligned_free(this->support_end);
     }
 
     /// Broadcasts a single `gaussian_t` to a set of `SIMD_FLOATS` gaussians.
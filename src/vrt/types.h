@@ -6,6 +6,9 @@
 #include <fmt/core.h>
 #include <fmt/format.h>
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <atomic>
 #ifdef INCLUDE_IMGUI
 #include <imgui.h>
 #endif
@@ -15,6 +18,11 @@
 
 namespace vrt
 {
+    /// sqrt(2/pi), not sqrt(2 pi).
+    constexpr f32 SQRT_2_PI = 0.7978845608028654f;
+    /// 1 / sqrt(2/pi) = sqrt(pi/2), not 1 / sqrt(2 pi).
+    constexpr f32 INV_SQRT_2_PI = 1.f/SQRT_2_PI;
+    constexpr f32 SQRT_2 = 1.4142135623730951f;
 
     struct vec4f_t
     {
@@ -192,19 +200,58 @@ namespace vrt
         }
     };
 
+    /// Support of a gaussian along a ray in multiples of sigma. Outside of it the error function is considered saturated.
+    constexpr f32 SUPPORT_RADIUS = 3.3f;
+
     struct gaussian_t
     {
         vec4f_t albedo;
         vec4f_t mu;
         f32 sigma;
         f32 magnitude;
+        /// Standard deviations along the principal axes of the gaussian in multiples of `sigma`. The principal axes are
+        /// the coordinate axes rotated by the unit quaternion `rotation` (x, y, z, w). The default is an isotropic gaussian.
+        vec4f_t scale{ .x = 1.f, .y = 1.f, .z = 1.f };
+        vec4f_t rotation{ .x = 0.f, .y = 0.f, .z = 0.f, .w = 1.f };
+        /// Distance in standard deviations beyond which the culling and tiling neglect the gaussian, see `cutoff_radius`.
+        f32 radius = SUPPORT_RADIUS;
+
+        /// Returns whether the gaussian has the same standard deviation `sigma` along all axes.
+        inline bool is_isotropic() const
+        {
+            return this->scale.x == 1.f && this->scale.y == 1.f && this->scale.z == 1.f;
+        }
+
+        /// Returns the largest standard deviation along the principal axes.
+        inline f32 max_sigma() const
+        {
+            return this->sigma * std::max({ this->scale.x, this->scale.y, this->scale.z });
+        }
+
+        /// Returns the radius of the sphere around `mu` outside of which the gaussian is neglected, i.e. `radius` largest
+        /// standard deviations.
+        inline f32 support() const
+        {
+            return this->radius * this->max_sigma();
+        }
+
+        /// Returns the inverse of the covariance matrix packed as xx, xy, xz, yy, yz, zz.
+        std::array<f32, 6> precision() const;
+
+        /// Returns the variance of the gaussian along `axis`, i.e. axis^T * covariance * axis.
+        f32 variance(const vec4f_t &axis) const;
 
         /// Returns the density of the gaussian at point `x`. Templated to allow for substitution
         /// of the used approximation of the exponential function.
         template<f32 (*Exp)(f32) = expf>
         f32 pdf(vec4f_t x) const
         {
-            return this->magnitude * Exp(-((x - this->mu).dot(x - this->mu))/(2 * this->sigma * this->sigma));
+            if (this->is_isotropic())
+                return this->magnitude * Exp(-((x - this->mu).dot(x - this->mu))/(2 * this->sigma * this->sigma));
+            const std::array<f32, 6> P = this->precision();
+            const vec4f_t d = x - this->mu;
+            return this->magnitude * Exp(-.5f * (P[0] * d.x * d.x + P[3] * d.y * d.y + P[5] * d.z * d.z
+                        + 2.f * (P[1] * d.x * d.y + P[2] * d.x * d.z + P[4] * d.y * d.z)));
         }
 #ifdef INCLUDE_IMGUI
         /// Creates controls for this `gaussian_t` instance. Uniqueness is ensured by using the address of the instance
@@ -216,6 +263,8 @@ namespace vrt
             this->mu.imgui_controls("mu");
             ImGui::SliderFloat("sigma", &this->sigma, .1f, 1.f);
             ImGui::SliderFloat("magnitude", &this->magnitude, 0.f, 10.f);
+            ImGui::SliderFloat3("scale", &this->scale.x, .1f, 10.f);
+            if (ImGui::SliderFloat4("rotation", &this->rotation.x, -1.f, 1.f)) this->rotation.normalize();
             ImGui::PopID();
         }
         /// Creates an ImGui window containing the controls for this `gaussian_t` instance.
@@ -228,6 +277,23 @@ namespace vrt
 #endif
     };
 
+    /// Statistics of the lanes allocated by `gaussian_vec_t::from_gaussians`.
+    struct soa_padding_t
+    {
+        /// Number of allocated lanes and of lanes without a gaussian since the last reset. The buffers are sized exactly, so
+        /// `padding` stays 0. `previous_padding` counts the lanes without a gaussian under the first sizing, which always
+        /// appended a whole vector of padding gaussians.
+        std::atomic<u64> lanes = 0, padding = 0, previous_padding = 0;
+
+        void reset()
+        {
+            this->lanes = 0;
+            this->padding = 0;
+            this->previous_padding = 0;
+        }
+    };
+    inline soa_padding_t soa_padding;
+
     // for easier loading into simd gaussians
     struct gaussian_vec_t
     {
@@ -245,7 +311,26 @@ namespace vrt
         } mu;
         f32 *sigma = nullptr;
         f32 *magnitude = nullptr;
-        u64 size = 0;
+        /// See `gaussian_t::support`.
+        f32 *support = nullptr;
+        /// Inverse covariance matrices, see `gaussian_t::precision`.
+        struct
+        {
+            f32 *xx = nullptr;
+            f32 *xy = nullptr;
+            f32 *xz = nullptr;
+            f32 *yy = nullptr;
+            f32 *yz = nullptr;
+            f32 *zz = nullptr;
+        } precision;
+        /// Constants derived from `sigma` and `magnitude` so that the kernels do not recompute them per ray and sample:
+        /// 1 / (2 sigma^2), 1 / (sqrt(2) sigma) and magnitude * sigma / sqrt(2/pi), which turns the exponential term of
+        /// `c_bar` into the weight of the error functions.
+        f32 *inv_2_sigma2 = nullptr;
+        f32 *inv_sqrt_2_sigma = nullptr;
+        f32 *weight_scale = nullptr;
+        /// Number of stored gaussians and number of gaussians the buffers have room for.
+        u64 size = 0, capacity = 0;
 
         /// Loads gaussians from a given `std::vector<gaussian_t>`.
         /// Only loads `this->size` gaussians.
@@ -253,7 +338,8 @@ namespace vrt
         void load_gaussians(const std::vector<gaussian_t> &gaussians);
 
         /// Creates a new `gaussian_vec_t` from a given `std::vector<gaussian_t>`.
-        /// `NATIVE_SIMD_WIDTH` aligned memory is allocated for the number of gaussians included in `gaussians`.
+        /// `NATIVE_SIMD_WIDTH` aligned memory is allocated for exactly the number of gaussians included in `gaussians`.
+        /// The kernels load the last vector with `masked_load`, which does not read past the last gaussian.
         static gaussian_vec_t *from_gaussians(const std::vector<gaussian_t> &gaussians);
 
         gaussian_vec_t() {}
@@ -261,23 +347,120 @@ namespace vrt
 
         /// Frees all allocated memory.
         ~gaussian_vec_t();
+
+        /// Stores `g` at position `i`, which needs to be below `capacity`.
+        void store(const u64 i, const gaussian_t *g);
+
+    private:
+        /// Returns all buffers of the vector.
+        std::array<f32**, 18> buffers();
     };
 
+    /// Scratch buffer for the quantities of a set of gaussians that only depend on the ray and not on the sample
+    /// distance `s`. The values are stored for a packet of `SIMD_FLOATS` rays, i.e. the values of the `i`-th gaussian
+    /// start at offset `i * SIMD_FLOATS`. `inv_sqrt_2_sigma` does not depend on the ray and holds one value per gaussian.
+    /// The standard deviation of anisotropic gaussians along a ray depends on the ray, so `inv_sqrt_2_sigma_bar` holds one
+    /// value per ray instead. It is only filled by `precompute_anisotropic_ray_params`.
+    struct ray_params_vec_t
+    {
+        f32 *mu_bar = nullptr;
+        f32 *mu_bar_sqrt_2_sigma = nullptr;
+        f32 *weight = nullptr;
+        f32 *erf1 = nullptr;
+        f32 *inv_sqrt_2_sigma = nullptr;
+        f32 *inv_sqrt_2_sigma_bar = nullptr;
+        u64 capacity = 0;
+
+        /// Grows the buffers to hold at least `size` gaussians. Existing values are not preserved.
+        void reserve(const u64 size);
+
+        ray_params_vec_t() {}
+        ray_params_vec_t(const ray_params_vec_t &other) = delete;
+
+        /// Frees all allocated memory.
+        ~ray_params_vec_t();
+    };
+
+    /// Scratch buffer for the projections of a set of gaussians onto the unnormalized rays p - o from an origin o through
+    /// the points p of a tile of the projection plane. For the pixel at the offset (x, y) from the corner of the tile
+    /// (mu - o) . (p - o) = `corner` + x * `dx` + y * `dy` and `sqnorm` holds |mu - o|^2.
+    struct plane_params_vec_t
+    {
+        f32 *corner = nullptr;
+        f32 *dx = nullptr;
+        f32 *dy = nullptr;
+        f32 *sqnorm = nullptr;
+        u64 capacity = 0;
+
+        /// Grows the buffers to hold at least `size` gaussians. Existing values are not preserved.
+        void reserve(const u64 size);
+
+        plane_params_vec_t() {}
+        plane_params_vec_t(const plane_params_vec_t &other) = delete;
+
+        /// Frees all allocated memory.
+        ~plane_params_vec_t();
+    };
+
+    /// Scratch buffer for the quantities of a set of gaussians along a single ray. The `sorted` arrays hold the first
+    /// `count` gaussians in order of their projected centers `mu_bar`, `order` maps them back to their original index and
+    /// `prefix_weight[i]` is the sum of the weights of the first `i` sorted gaussians. `erf1_sum` is the sum of the
+    /// weighted first error functions of the sorted gaussians. `support_end[i]` is the furthest end of the supports
+    /// `mu_bar +- SUPPORT_RADIUS * sigma` of the first `i + 1` sorted gaussians and `support_begin[i]` the closest begin
+    /// of the supports of the sorted gaussians from `i` on, so both are sorted as well.
+    /// All arrays are padded by `SIMD_FLOATS` elements so that vectors can be loaded starting at any gaussian.
+    struct sorted_params_vec_t
+    {
+        struct
+        {
+            f32 *mu_bar = nullptr;
+            f32 *mu_bar_sqrt_2_sigma = nullptr;
+            f32 *weight = nullptr;
+            f32 *inv_sqrt_2_sigma = nullptr;
+        } unsorted, sorted;
+        f32 *prefix_weight = nullptr;
+        f32 *support_begin = nullptr;
+        f32 *support_end = nullptr;
+        std::vector<u32> order;
+        u64 count = 0;
+        f32 erf1_sum = 0.f;
+        u64 capacity = 0;
+
+        /// Grows the buffers to hold at least `size` gaussians. Existing values are not preserved.
+        void reserve(const u64 size);
+
+        sorted_params_vec_t() {}
+        sorted_params_vec_t(const sorted_params_vec_t &other) = delete;
+
+        /// Frees all allocated memory.
+        ~sorted_params_vec_t();
+    };
+
+    struct bvh_t;
+    struct grid_t;
+
     struct gaussians_t
     {
         std::vector<gaussian_t> gaussians;
         gaussian_vec_t *soa_gaussians = nullptr;
+        /// Optional hierarchy over `gaussians` for `bvh_cull_gaussians`.
+        const bvh_t *bvh = nullptr;
+        /// Optional uniform grid over `gaussians` for `grid_cull_gaussians`.
+        const grid_t *grid = nullptr;
     };
 
     struct tiles_t
     {
-        const std::vector<gaussians_t> gaussians;
+        /// NOTE: not const so that `incremental_tiler_t` can replace the gaussians of single tiles
+        std::vector<gaussians_t> gaussians;
         const f32 tw;
         const f32 th;
         const u64 w, h;
 
         /// TODO: number of horizontal tiles and vertical tiles should probably be given explicitly
         tiles_t(const std::vector<gaussians_t> &gaussians, const f32 tw, const f32 th) : gaussians(gaussians), tw(tw), th(th), w(std::ceil(2.f/tw)), h(std::ceil(2.f/th)) {}
+        /// Takes over the gaussians of `other`, which is left without tiles.
+        tiles_t(tiles_t &&other) : gaussians(std::move(other.gaussians)), tw(other.tw), th(other.th), w(other.w), h(other.h) {}
 
         /// Destroy all `gaussian_vec_t`s since they will not go out of scope naturally.
         ~tiles_t() {
@@ -286,6 +469,29 @@ namespace vrt
         }
     };
 
+    /// Tile of `w` x `h` pixels starting at the pixel (`x`, `y`) of the image together with the gaussians that affect it.
+    struct quadtree_tile_t
+    {
+        u64 x, y, w, h;
+        gaussians_t gaussians;
+    };
+
+    /// Variable size tiles that cover an image, see `quadtree_tile_gaussians`.
+    struct quadtree_tiles_t
+    {
+        std::vector<quadtree_tile_t> tiles;
+
+        quadtree_tiles_t() = default;
+        quadtree_tiles_t(const quadtree_tiles_t &other) = delete;
+        quadtree_tiles_t(quadtree_tiles_t &&other) : tiles(std::move(other.tiles)) {}
+
+        /// Destroy all `gaussian_vec_t`s since they will not go out of scope naturally.
+        ~quadtree_tiles_t() {
+            for (const quadtree_tile_t &t : this->tiles)
+                delete t.gaussians.soa_gaussians;
+        }
+    };
+
     struct simd_gaussian_t
     {
         simd_vec4f_t albedo;
@@ -1,6 +1,10 @@
 #pragma once
 #include "types.h"
 #include "rt.h"
+#include "fp16.h"
 #include "gaussians-from-file.h"
 #include "camera.h"
 #include "approx.h"
+#include "lod.h"
+#include "bvh.h"
+#include "grid.h"